@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <cstring>
+#include <cmath>
 #include <iostream>
 
 typedef double MatrixItem;
@@ -38,7 +39,11 @@ public:
     void set_one();
     Matrix& trans();
     MatrixItem det(Matrix& A);
+    MatrixItem log_det(Matrix& A, int& sign);
     Matrix& exp(unsigned int idx = 100);
+private:
+    static MatrixItem det4(const MatrixItem* a);
+    static MatrixItem lu_det(const Matrix& A, MatrixItem* log_abs, int* sign);
 public:
     void print(const Matrix& A);
 };
@@ -287,6 +292,82 @@ Matrix& Matrix::operator*=(const MatrixItem k)
 }
 
 
+// DET (A) for a 4x4 block: expansion by the 2x2 minors of rows 0-1 and 2-3
+MatrixItem Matrix::det4(const MatrixItem* a)
+{
+    const MatrixItem s0 = a[0] * a[5] - a[1] * a[4];
+    const MatrixItem s1 = a[0] * a[6] - a[2] * a[4];
+    const MatrixItem s2 = a[0] * a[7] - a[3] * a[4];
+    const MatrixItem s3 = a[1] * a[6] - a[2] * a[5];
+    const MatrixItem s4 = a[1] * a[7] - a[3] * a[5];
+    const MatrixItem s5 = a[2] * a[7] - a[3] * a[6];
+
+    const MatrixItem c5 = a[10] * a[15] - a[11] * a[14];
+    const MatrixItem c4 = a[9] * a[15] - a[11] * a[13];
+    const MatrixItem c3 = a[9] * a[14] - a[10] * a[13];
+    const MatrixItem c2 = a[8] * a[15] - a[11] * a[12];
+    const MatrixItem c1 = a[8] * a[14] - a[10] * a[12];
+    const MatrixItem c0 = a[8] * a[13] - a[9] * a[12];
+
+    return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+}
+
+
+// DET (A) by LU with partial pivoting on a scratch copy.
+// Returns the plain product; log|det| and the sign are filled when asked for,
+// they stay finite where the product over- or underflows.
+MatrixItem Matrix::lu_det(const Matrix& A, MatrixItem* log_abs, int* sign)
+{
+    const size_t n = A.rows;
+    MatrixItem* lu = new MatrixItem[n * n];
+    std::memcpy(lu, A.data, n * n * sizeof(MatrixItem));
+
+    MatrixItem det = 1.;
+    MatrixItem log_sum = 0.;
+    int det_sign = 1;
+
+    for (size_t col = 0; col < n; ++col) {
+        size_t pivot = col;
+        for (size_t row = col + 1; row < n; ++row)
+            if (std::fabs(lu[row * n + col]) > std::fabs(lu[pivot * n + col]))
+                pivot = row;
+
+        if (lu[pivot * n + col] == 0.) {
+            det = 0.;
+            det_sign = 0;
+            log_sum = -INFINITY;
+            break;
+        }
+
+        if (pivot != col) {
+            for (size_t idx = col; idx < n; ++idx)
+                std::swap(lu[col * n + idx], lu[pivot * n + idx]);
+            det_sign = -det_sign;
+            det = -det;
+        }
+
+        const MatrixItem* pivot_row = lu + col * n;
+        const MatrixItem diag = pivot_row[col];
+        det *= diag;
+        log_sum += std::log(std::fabs(diag));
+        if (diag < 0.) det_sign = -det_sign;
+
+        for (size_t row = col + 1; row < n; ++row) {
+            MatrixItem* cur_row = lu + row * n;
+            const MatrixItem factor = cur_row[col] / diag;
+            for (size_t idx = col + 1; idx < n; ++idx)
+                cur_row[idx] -= factor * pivot_row[idx];
+        }
+    }
+
+    delete[] lu;
+
+    if (log_abs != nullptr) *log_abs = log_sum;
+    if (sign != nullptr) *sign = det_sign;
+    return det;
+}
+
+
 // DET (A)
 MatrixItem Matrix::det(Matrix& A)
 {
@@ -307,7 +388,27 @@ MatrixItem Matrix::det(Matrix& A)
             - A.data[1] * A.data[3] * A.data[8]
             - A.data[5] * A.data[7] * A.data[0]);
     };
-    throw Matrix_Exception("det: Matrix size too large");
+    if (A.rows == 4) return det4(A.data);
+
+    return lu_det(A, nullptr, nullptr);
+}
+
+
+// ln|DET (A)|, sign = -1, 0 or 1
+MatrixItem Matrix::log_det(Matrix& A, int& sign)
+{
+    if (A.rows != A.cols)
+        throw Matrix_Exception("log_det: Not square");
+
+    if (A.rows <= 4) {
+        const MatrixItem value = det(A);
+        sign = (value > 0.) - (value < 0.);
+        return std::log(std::fabs(value));
+    }
+
+    MatrixItem log_abs = 0.;
+    lu_det(A, &log_abs, &sign);
+    return log_abs;
 }
 
 
@@ -331,7 +432,44 @@ Matrix& Matrix::exp(unsigned int idx)
 }
 
 
-int main() {
+// DET (A) by cofactor expansion along the first row, reference for the tests
+MatrixItem det_reference(const MatrixItem* a, const size_t n)
+{
+    if (n == 1) return a[0];
+
+    MatrixItem* minor = new MatrixItem[(n - 1) * (n - 1)];
+    MatrixItem det = 0.;
+    MatrixItem sign = 1.;
+    for (size_t col = 0; col < n; ++col) {
+        size_t idx = 0;
+        for (size_t row = 1; row < n; ++row)
+            for (size_t cur = 0; cur < n; ++cur)
+                if (cur != col) minor[idx++] = a[row * n + cur];
+        det += sign * a[col] * det_reference(minor, n - 1);
+        sign = -sign;
+    }
+    delete[] minor;
+    return det;
+}
 
 
+void test_det()
+{
+    MatrixItem values[36];
+    for (size_t n = 1; n <= 6; ++n) {
+        for (size_t idx = 0; idx < n * n; ++idx)
+            values[idx] = (MatrixItem)(rand() % 19 - 9);
+
+        Matrix A(n, n, values);
+        const MatrixItem expected = det_reference(values, n);
+        const MatrixItem result = A.det(A);
+        const bool ok = std::fabs(result - expected) <= 1e-9 * (1. + std::fabs(expected));
+        std::cout << (ok ? "SUCCESS" : "FAIL") << " det " << n << "x" << n
+            << ": " << result << " (expected " << expected << ")" << std::endl;
+    }
+}
+
+
+int main() {
+    test_det();
 }
\ No newline at end of file
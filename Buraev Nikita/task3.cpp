@@ -1,40 +1,52 @@
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
+#include <string>
+#include <utility>
 
-#include "matrix.hpp"
+#include "task3.hpp"
+
+template <typename Type>
+bool Matrix<Type>::strassen_enabled = std::is_integral<Type>::value;
+
+template <typename Type>
+std::size_t Matrix<Type>::strassen_cutoff = 128;
 
 template <typename Type>
 Matrix<Type>::Matrix(std::initializer_list<std::initializer_list<Type>> matrix)
+    : rows(matrix.size()), cols(matrix.size() > 0 ? matrix.begin()->size() : 0)
 {
+    elements.reserve(rows * cols);
+
     for (const auto &mat : matrix)
     {
-        std::vector<Type> row(mat);
-        elements.push_back(row);
-    }
+        if (mat.size() != cols)
+        {
+            throw std::invalid_argument("All matrix rows must have the same length.");
+        }
 
-    rows = elements.size();
-    cols = (rows > 0) ? elements[0].size() : 0;
+        elements.insert(elements.end(), mat.begin(), mat.end());
+    }
 }
 
 template <typename Type>
 Matrix<Type>::Matrix(std::initializer_list<Type> matrix)
+    : elements(matrix), rows(1), cols(matrix.size())
 {
-    std::vector<Type> row(matrix);
-    elements.push_back(row);
+}
 
-    rows = 1;
-    cols = (rows > 0) ? elements[0].size() : 0;
+template <typename Type>
+Matrix<Type>::Matrix(std::size_t _rows, std::size_t _cols, Type _init)
+    : elements(_rows * _cols, _init), rows(_rows), cols(_cols)
+{
 }
 
 template <typename Type>
 Matrix<Type>::Matrix(unsigned size)
+    : elements(static_cast<std::size_t>(size) * size, Type{0}), rows(size), cols(size)
 {
-    elements.resize(size, std::vector<Type>(size, Type{0}));
-
-    for (unsigned i = 0; i < size; ++i)
-        elements[i][i] = Type{1};
-
-    rows = cols = size;
+    for (std::size_t i = 0; i < size; ++i)
+        elements[i * cols + i] = Type{1};
 }
 
 template <typename Type>
@@ -63,11 +75,10 @@ Matrix<Type> Matrix<Type>::operator+(const Matrix<Type> &right) const
         throw std::invalid_argument("Matrix addition requires matrices of the same dimensions.");
     }
 
-    Matrix result(rows, cols, elements[0][0]);
+    Matrix result(rows, cols, Type{0});
 
-    for (std::size_t i = 0; i < rows; ++i)
-        for (std::size_t j = 0; j < cols; ++j)
-            result.elements[i][j] = elements[i][j] + right.elements[i][j];
+    for (std::size_t idx = 0; idx < elements.size(); ++idx)
+        result.elements[idx] = elements[idx] + right.elements[idx];
 
     return result;
 }
@@ -80,9 +91,8 @@ Matrix<Type> &Matrix<Type>::operator+=(const Matrix<Type> &right)
         throw std::invalid_argument("Matrix addition requires matrices of the same dimensions.");
     }
 
-    for (std::size_t i = 0; i < rows; ++i)
-        for (std::size_t j = 0; j < cols; ++j)
-            elements[i][j] += right.elements[i][j];
+    for (std::size_t idx = 0; idx < elements.size(); ++idx)
+        elements[idx] += right.elements[idx];
 
     return *this;
 }
@@ -95,11 +105,10 @@ Matrix<Type> Matrix<Type>::operator-(const Matrix<Type> &right) const
         throw std::invalid_argument("Matrix subtraction requires matrices of the same dimensions.");
     }
 
-    Matrix result(rows, cols, elements[0][0]);
+    Matrix result(rows, cols, Type{0});
 
-    for (std::size_t i = 0; i < rows; ++i)
-        for (std::size_t j = 0; j < cols; ++j)
-            result.elements[i][j] = elements[i][j] - right.elements[i][j];
+    for (std::size_t idx = 0; idx < elements.size(); ++idx)
+        result.elements[idx] = elements[idx] - right.elements[idx];
 
     return result;
 }
@@ -112,9 +121,8 @@ Matrix<Type> &Matrix<Type>::operator-=(const Matrix<Type> &right)
         throw std::invalid_argument("Matrix subtraction requires matrices of the same dimensions.");
     }
 
-    for (std::size_t i = 0; i < rows; ++i)
-        for (std::size_t j = 0; j < cols; ++j)
-            elements[i][j] -= right.elements[i][j];
+    for (std::size_t idx = 0; idx < elements.size(); ++idx)
+        elements[idx] -= right.elements[idx];
 
     return *this;
 }
@@ -127,22 +135,155 @@ Matrix<Type> Matrix<Type>::operator*(const Matrix<Type> &right) const
         throw std::invalid_argument("Matrices are incompatible for multiplication");
     }
 
-    Matrix result(rows, right.cols, elements[0][0]);
+    Matrix result(rows, right.cols, Type{0});
+    multiply_into(*this, right, result);
 
-    for (std::size_t i = 0; i < rows; ++i)
+    return result;
+}
+
+// c = a * b, c already sized a.rows x b.cols and aliasing neither.
+// The one place that picks Strassen or the classic loop, so products,
+// powers and the MatrixPowers ladder all go the same way.
+template <typename Type>
+void Matrix<Type>::multiply_into(const Matrix<Type> &a, const Matrix<Type> &b, Matrix<Type> &c)
+{
+    if (strassen_enabled && a.is_square() && b.is_square() && a.rows > strassen_cutoff)
     {
-        for (std::size_t j = 0; j < right.cols; ++j)
-        {
-            Type sum = 0;
+        a.strassen_multiply(b, c);
+        return;
+    }
 
-            for (std::size_t k = 0; k < cols; ++k)
-                sum += elements[i][k] * right.elements[k][j];
+    classic_product(a.elements.data(), a.cols, b.elements.data(), b.cols,
+                    c.elements.data(), c.cols, a.rows, a.cols, b.cols);
+}
 
-            result.elements[i][j] = sum;
+// c[m x n] = a[m x k] * b[k x n]; i-k-j order keeps the inner loop on contiguous rows
+template <typename Type>
+void Matrix<Type>::classic_product(const Type *a, std::size_t lda, const Type *b, std::size_t ldb,
+                                   Type *c, std::size_t ldc, std::size_t m, std::size_t k, std::size_t n)
+{
+    for (std::size_t i = 0; i < m; ++i)
+    {
+        Type *c_row = c + i * ldc;
+
+        for (std::size_t j = 0; j < n; ++j)
+            c_row[j] = Type{0};
+
+        for (std::size_t p = 0; p < k; ++p)
+        {
+            const Type factor = a[i * lda + p];
+            const Type *b_row = b + p * ldb;
+
+            for (std::size_t j = 0; j < n; ++j)
+                c_row[j] += factor * b_row[j];
         }
     }
+}
 
-    return result;
+// Winograd's form of Strassen: 7 half-size products and 15 additions.
+// C is used as scratch for the products, `work` must hold 4 * (n / 2)^2 items
+// for this level and every level below it.
+template <typename Type>
+void Matrix<Type>::strassen_product(const Type *a, std::size_t lda, const Type *b, std::size_t ldb,
+                                    Type *c, std::size_t ldc, std::size_t n, Type *work)
+{
+    if (n <= strassen_cutoff || n % 2 != 0)
+    {
+        classic_product(a, lda, b, ldb, c, ldc, n, n, n);
+        return;
+    }
+
+    const std::size_t h = n / 2;
+    const Type *a11 = a, *a12 = a + h, *a21 = a + h * lda, *a22 = a + h * lda + h;
+    const Type *b11 = b, *b12 = b + h, *b21 = b + h * ldb, *b22 = b + h * ldb + h;
+    Type *c11 = c, *c12 = c + h, *c21 = c + h * ldc, *c22 = c + h * ldc + h;
+    Type *x = work, *y = work + h * h, *z = work + 2 * h * h;
+    Type *next = work + 3 * h * h;
+
+    auto each = [h](auto &&op)
+    {
+        for (std::size_t i = 0; i < h; ++i)
+            for (std::size_t j = 0; j < h; ++j)
+                op(i, j);
+    };
+
+    // M7 = (A11 - A21)(B22 - B12) -> C21
+    each([&](std::size_t i, std::size_t j) { x[i * h + j] = a11[i * lda + j] - a21[i * lda + j]; });
+    each([&](std::size_t i, std::size_t j) { y[i * h + j] = b22[i * ldb + j] - b12[i * ldb + j]; });
+    strassen_product(x, h, y, h, c21, ldc, h, next);
+
+    // S1 = A21 + A22, T1 = B12 - B11, M5 = S1 T1 -> C22
+    each([&](std::size_t i, std::size_t j) { x[i * h + j] = a21[i * lda + j] + a22[i * lda + j]; });
+    each([&](std::size_t i, std::size_t j) { y[i * h + j] = b12[i * ldb + j] - b11[i * ldb + j]; });
+    strassen_product(x, h, y, h, c22, ldc, h, next);
+
+    // S2 = S1 - A11, T2 = B22 - T1, M6 = S2 T2 -> C12
+    each([&](std::size_t i, std::size_t j) { x[i * h + j] -= a11[i * lda + j]; });
+    each([&](std::size_t i, std::size_t j) { y[i * h + j] = b22[i * ldb + j] - y[i * h + j]; });
+    strassen_product(x, h, y, h, c12, ldc, h, next);
+
+    // S4 = A12 - S2, M3 = S4 B22 -> C11
+    each([&](std::size_t i, std::size_t j) { x[i * h + j] = a12[i * lda + j] - x[i * h + j]; });
+    strassen_product(x, h, b22, ldb, c11, ldc, h, next);
+
+    // M1 = A11 B11 -> Z
+    strassen_product(a11, lda, b11, ldb, z, h, h, next);
+
+    each([&](std::size_t i, std::size_t j)
+    {
+        Type u2 = z[i * h + j] + c12[i * ldc + j];
+        Type u3 = u2 + c21[i * ldc + j];
+        Type u4 = u2 + c22[i * ldc + j];
+
+        c12[i * ldc + j] = u4 + c11[i * ldc + j];
+        c21[i * ldc + j] = u3;
+        c22[i * ldc + j] = u3 + c22[i * ldc + j];
+    });
+
+    // T4 = T2 - B21, M4 = A22 T4, C21 = U3 - M4
+    each([&](std::size_t i, std::size_t j) { y[i * h + j] -= b21[i * ldb + j]; });
+    strassen_product(a22, lda, y, h, c11, ldc, h, next);
+    each([&](std::size_t i, std::size_t j) { c21[i * ldc + j] -= c11[i * ldc + j]; });
+
+    // M2 = A12 B21, C11 = M1 + M2
+    strassen_product(a12, lda, b21, ldb, c11, ldc, h, next);
+    each([&](std::size_t i, std::size_t j) { c11[i * ldc + j] += z[i * h + j]; });
+}
+
+template <typename Type>
+void Matrix<Type>::strassen_multiply(const Matrix<Type> &right, Matrix<Type> &result) const
+{
+    // Pad with zeros to cutoff-sized blocks halved `levels` times, not to a power of two
+    std::size_t block = rows;
+    std::size_t levels = 0;
+
+    while (block > strassen_cutoff)
+    {
+        block = (block + 1) / 2;
+        ++levels;
+    }
+
+    const std::size_t n = block << levels;
+    std::vector<Type> work(4 * (n / 2) * (n / 2) + 1);
+
+    if (n == rows)
+    {
+        strassen_product(elements.data(), n, right.elements.data(), n, result.elements.data(), n, n, work.data());
+        return;
+    }
+
+    std::vector<Type> a(n * n, Type{0}), b(n * n, Type{0}), c(n * n);
+
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        std::copy_n(elements.begin() + i * cols, cols, a.begin() + i * n);
+        std::copy_n(right.elements.begin() + i * cols, cols, b.begin() + i * n);
+    }
+
+    strassen_product(a.data(), n, b.data(), n, c.data(), n, n, work.data());
+
+    for (std::size_t i = 0; i < rows; ++i)
+        std::copy_n(c.begin() + i * n, cols, result.elements.begin() + i * cols);
 }
 
 template <typename Type>
@@ -155,11 +296,10 @@ Matrix<Type> &Matrix<Type>::operator*=(const Matrix<Type> &right)
 template <typename Type>
 Matrix<Type> Matrix<Type>::operator+(const Type &right) const
 {
-    Matrix result(rows, cols, elements[0][0]);
+    Matrix result(rows, cols, Type{0});
 
-    for (std::size_t i = 0; i < rows; ++i)
-        for (std::size_t j = 0; j < cols; ++j)
-            result.elements[i][j] = this->elements[i][j] + right;
+    for (std::size_t idx = 0; idx < elements.size(); ++idx)
+        result.elements[idx] = elements[idx] + right;
 
     return result;
 }
@@ -172,11 +312,10 @@ Matrix<Type> Matrix<Type>::operator/(const Type &right) const
         throw std::invalid_argument("Division by zero.");
     }
 
-    Matrix result(rows, cols, elements[0][0]);
+    Matrix result(rows, cols, Type{0});
 
-    for (std::size_t i = 0; i < rows; ++i)
-        for (std::size_t j = 0; j < cols; ++j)
-            result.elements[i][j] = this->elements[i][j] / right;
+    for (std::size_t idx = 0; idx < elements.size(); ++idx)
+        result.elements[idx] = elements[idx] / right;
 
     return result;
 }
@@ -184,11 +323,10 @@ Matrix<Type> Matrix<Type>::operator/(const Type &right) const
 template <typename Type>
 Matrix<Type> Matrix<Type>::operator-(const Type &right) const
 {
-    Matrix result(rows, cols, elements[0][0]);
+    Matrix result(rows, cols, Type{0});
 
-    for (std::size_t i = 0; i < rows; ++i)
-        for (std::size_t j = 0; j < cols; ++j)
-            result.elements[i][j] = this->elements[i][j] - right;
+    for (std::size_t idx = 0; idx < elements.size(); ++idx)
+        result.elements[idx] = elements[idx] - right;
 
     return result;
 }
@@ -196,11 +334,10 @@ Matrix<Type> Matrix<Type>::operator-(const Type &right) const
 template <typename Type>
 Matrix<Type> Matrix<Type>::operator*(const Type &right) const
 {
-    Matrix result(rows, cols, elements[0][0]);
+    Matrix result(rows, cols, Type{0});
 
-    for (std::size_t i = 0; i < rows; ++i)
-        for (std::size_t j = 0; j < cols; ++j)
-            result.elements[i][j] = this->elements[i][j] * right;
+    for (std::size_t idx = 0; idx < elements.size(); ++idx)
+        result.elements[idx] = elements[idx] * right;
 
     return result;
 }
@@ -241,7 +378,7 @@ Type &Matrix<Type>::operator()(std::size_t i, std::size_t j)
         throw std::out_of_range("Matrix index out of bounds!");
     }
 
-    return elements[i][j];
+    return elements[i * cols + j];
 }
 
 template <typename Type>
@@ -252,7 +389,7 @@ const Type &Matrix<Type>::operator()(std::size_t i, std::size_t j) const
         throw std::out_of_range("Matrix index out of bounds!");
     }
 
-    return elements[i][j];
+    return elements[i * cols + j];
 }
 
 template <typename Type>
@@ -261,7 +398,7 @@ void Matrix<Type>::print() const
     for (std::size_t i = 0; i < rows; ++i)
     {
         for (std::size_t j = 0; j < cols; ++j)
-            std::cout << elements[i][j] << " ";
+            std::cout << elements[i * cols + j] << " ";
 
         std::cout << std::endl;
     }
@@ -277,7 +414,7 @@ Type &Matrix<Type>::element(std::size_t i, std::size_t j)
                                 " exceeds matrix dimensions (" + std::to_string(rows) + ", " + std::to_string(cols) + ")"
                                 " in file " + std::string(__FILE__) + " at line " + std::to_string(__LINE__));
     }
-    return elements[i][j];
+    return elements[i * cols + j];
 }
 
 template <typename Type>
@@ -301,11 +438,11 @@ Type &Matrix<Type>::element(std::size_t i)
         throw std::runtime_error("Matrix is empty! Index out of bounds!");
     }
 
-    return elements[0][i];
+    return elements[i];
 }
 
 template <typename Type>
-Type &Matrix<Type>::element(std::size_t i, std::size_t j) const
+const Type &Matrix<Type>::element(std::size_t i, std::size_t j) const
 {
     if (i >= rows || j >= cols)
     {
@@ -314,11 +451,11 @@ Type &Matrix<Type>::element(std::size_t i, std::size_t j) const
                                 " exceeds matrix dimensions (" + std::to_string(rows) + ", " + std::to_string(cols) + ")"
                                 " in file " + std::string(__FILE__) + " at line " + std::to_string(__LINE__));
     }
-    return elements[i][j];
+    return elements[i * cols + j];
 }
 
 template <typename Type>
-Type &Matrix<Type>::element(std::size_t i) const
+const Type &Matrix<Type>::element(std::size_t i) const
 {
     if (rows > 1)
     {
@@ -338,17 +475,33 @@ Type &Matrix<Type>::element(std::size_t i) const
         throw std::runtime_error("Matrix is empty! Index out of bounds!");
     }
 
-    return elements[0][i];
+    return elements[i];
 }
 
 template <typename Type>
 Matrix<Type> Matrix<Type>::transpose() const
 {
-    Matrix<Type> result(cols, rows, elements[0][0]);
+    // 16 x 16 tiles: the 16 source rows a tile reads stay cached while every
+    // result row is written contiguously. Raw pointers let the compiler keep
+    // both bases in registers instead of reloading them through the vectors.
+    const std::size_t tile = 16;
+    Matrix<Type> result(cols, rows, Type{0});
+    const Type *src = elements.data();
+    Type *dst = result.elements.data();
+
+    for (std::size_t i0 = 0; i0 < rows; i0 += tile)
+    {
+        const std::size_t i1 = std::min(rows, i0 + tile);
 
-    for (std::size_t i = 0; i < rows; ++i)
-        for (std::size_t j = 0; j < cols; ++j)
-            result.elements[j][i] = elements[i][j];
+        for (std::size_t j0 = 0; j0 < cols; j0 += tile)
+        {
+            const std::size_t j1 = std::min(cols, j0 + tile);
+
+            for (std::size_t j = j0; j < j1; ++j)
+                for (std::size_t i = i0; i < i1; ++i)
+                    dst[j * rows + i] = src[i * cols + j];
+        }
+    }
 
     return result;
 }
@@ -367,12 +520,95 @@ Matrix<Type> Matrix<Type>::power(unsigned n) const
         return result;
     }
 
-    Matrix result(rows, cols, elements[0][0]);
-    result = *this;
+    // Exponentiation by squaring: base and result each ping-pong with one scratch buffer
+    Matrix base(*this);
+    Matrix result(*this);
+    Matrix scratch(rows, cols, Type{0});
+    bool started = false;
+
+    for (;;)
+    {
+        if (n & 1u)
+        {
+            if (started)
+            {
+                multiply_into(result, base, scratch);
+                result.elements.swap(scratch.elements);
+            }
+            else
+            {
+                result.elements = base.elements;
+                started = true;
+            }
+        }
+
+        n >>= 1;
+
+        if (n == 0)
+            break;
+
+        multiply_into(base, base, scratch);
+        base.elements.swap(scratch.elements);
+    }
+
+    return result;
+}
+
+template <typename Type>
+MatrixPowers<Type>::MatrixPowers(const Matrix<Type> &base)
+{
+    if (!base.is_square())
+    {
+        throw std::invalid_argument("Matrix is incompatible for power() | rows != cols\n");
+    }
+
+    ladder.push_back(base);
+}
+
+template <typename Type>
+Matrix<Type> MatrixPowers<Type>::power(unsigned n)
+{
+    const std::size_t size = ladder[0].rows;
+
+    if (n == 0)
+    {
+        Matrix<Type> result(static_cast<unsigned>(size));
+        return result;
+    }
+
+    std::size_t levels = 0;
 
-    for (unsigned i = 1; i < n; ++i)
+    for (unsigned bits = n; bits != 0; bits >>= 1)
+        ++levels;
+
+    while (ladder.size() < levels)
     {
-        result *= *this;
+        const Matrix<Type> &last = ladder.back();
+        Matrix<Type> next(size, size, Type{0});
+
+        Matrix<Type>::multiply_into(last, last, next);
+        ladder.push_back(std::move(next));
+    }
+
+    Matrix<Type> result;
+    Matrix<Type> scratch(size, size, Type{0});
+    bool started = false;
+
+    for (std::size_t k = 0; k < levels; ++k)
+    {
+        if (!((n >> k) & 1u))
+            continue;
+
+        if (started)
+        {
+            Matrix<Type>::multiply_into(result, ladder[k], scratch);
+            result.elements.swap(scratch.elements);
+        }
+        else
+        {
+            result = ladder[k];
+            started = true;
+        }
     }
 
     return result;
@@ -5,14 +5,31 @@
 #include <iostream>
 #include <cmath>
 #include <vector>
+#include <type_traits>
 #include <initializer_list>
 
+template <typename Type> class MatrixPowers;
+
 template <typename Type> class Matrix
 {
     private:
-            std::vector< std::vector<Type> > elements;
-            unsigned int rows;
-            unsigned int cols;
+            std::vector<Type> elements;  // row-major, element (i, j) at i * cols + j
+            std::size_t rows;
+            std::size_t cols;
+
+            // Strassen-Winograd is used for square products larger than the cutoff.
+            // On by default only for integral types: for floating point it changes rounding.
+            static bool strassen_enabled;
+            static std::size_t strassen_cutoff;
+
+            static void classic_product(const Type * a, std::size_t lda, const Type * b, std::size_t ldb,
+                                        Type * c, std::size_t ldc, std::size_t m, std::size_t k, std::size_t n);
+            static void strassen_product(const Type * a, std::size_t lda, const Type * b, std::size_t ldb,
+                                         Type * c, std::size_t ldc, std::size_t n, Type * work);
+            void strassen_multiply(const Matrix<Type> & right, Matrix<Type> & result) const;
+            static void multiply_into(const Matrix<Type> & a, const Matrix<Type> & b, Matrix<Type> & c);
+
+            friend class MatrixPowers<Type>;
 
     public:
 
@@ -20,7 +37,7 @@ template <typename Type> class Matrix
             Matrix() : rows(0), cols(0) {}
             Matrix(std::initializer_list< std::initializer_list<Type> > matrix);
             Matrix(std::initializer_list<Type> matrix);
-            Matrix(unsigned int _rows, unsigned int _cols, Type _init);
+            Matrix(std::size_t _rows, std::size_t _cols, Type _init);
             Matrix(unsigned _size); //Creates Identity Matrix
             Matrix(const Matrix<Type> & original);
 
@@ -29,34 +46,31 @@ template <typename Type> class Matrix
 
 
             Matrix<Type> & operator= (const Matrix<Type> & right);
-            Matrix<Type>   operator+ (const Matrix<Type> & right);
+            Matrix<Type>   operator+ (const Matrix<Type> & right) const;
             Matrix<Type> & operator+=(const Matrix<Type> & right);
-            Matrix<Type>   operator- (const Matrix<Type> & right);
+            Matrix<Type>   operator- (const Matrix<Type> & right) const;
             Matrix<Type> & operator-=(const Matrix<Type> & right);
-            Matrix<Type>   operator* (const Matrix<Type> & right);
+            Matrix<Type>   operator* (const Matrix<Type> & right) const;
             Matrix<Type> & operator*=(const Matrix<Type> & right);
 
             //scalar
-            Matrix<Type> operator+(const Type & right);
-            Matrix<Type> operator-(const Type & right);
-            Matrix<Type> operator*(const Type & right);
-            Matrix<Type> operator/(const Type & right);
+            Matrix<Type> operator+(const Type & right) const;
+            Matrix<Type> operator-(const Type & right) const;
+            Matrix<Type> operator*(const Type & right) const;
+            Matrix<Type> operator/(const Type & right) const;
             Matrix<Type> & operator+=(const Type & right);
             Matrix<Type> & operator-=(const Type & right);
             Matrix<Type> & operator*=(const Type & right);
             Matrix<Type> & operator/=(const Type & right);
-            Type & operator()(const unsigned & i, const unsigned & j);
+            Type & operator()(std::size_t i, std::size_t j);
+            const Type & operator()(std::size_t i, std::size_t j) const;
 
 
             friend bool operator==(const Matrix<Type> & m1, const Matrix<Type> & m2)
             {
               if (m1.rows != m2.rows || m1.cols != m2.cols) return false;
 
-              for (unsigned i = 0; i < m1.rows; i++)
-               for (unsigned j = 0; j < m1.cols; j++)
-                if (m1.elements[i][j] != m2.elements[i][j]) return false;
-
-              return true;
+              return m1.elements == m2.elements;
             }
 
             friend bool operator!=(const Matrix<Type> & m1, const Matrix<Type> & m2) { return m1 == m2 ? false : true; }
@@ -65,19 +79,36 @@ template <typename Type> class Matrix
             friend Matrix<Type> operator-(const Type & value, Matrix<Type> & right) { return right - value; }
 
     
-            void print();
-            unsigned getRows() const;
-            unsigned getCols() const;
-            Type & element(unsigned & i, unsigned & j);
-            Type & element(const unsigned & i, const unsigned & j);
-            Type & element(unsigned & i);
-            Type & element(const unsigned & i);
-            bool is_square() {return cols == rows;}
+            void print() const;
+            std::size_t getRows() const;
+            std::size_t getCols() const;
+            Type & element(std::size_t i, std::size_t j);
+            const Type & element(std::size_t i, std::size_t j) const;
+            Type & element(std::size_t i);
+            const Type & element(std::size_t i) const;
+            bool is_square() const;
             Matrix<Type> transpose() const;
-            Matrix<Type> power(unsigned n);
+            Matrix<Type> power(unsigned n) const;
 
+            static void set_strassen(bool enabled) { strassen_enabled = enabled; }
+            static void set_strassen_cutoff(std::size_t cutoff) { strassen_cutoff = (cutoff < 1) ? 1 : cutoff; }
+
+};
+
+// Caches the ladder A, A^2, A^4, ... of a copy of A, so repeated powers of the
+// same matrix only pay for the squarings once. Later changes to A are not seen.
+template <typename Type> class MatrixPowers
+{
+    private:
+            std::vector< Matrix<Type> > ladder;
+
+    public:
+            explicit MatrixPowers(const Matrix<Type> & base);
+
+            Matrix<Type> power(unsigned n);
+            std::size_t cached_squarings() const { return ladder.size() - 1; }
 };
 
-#include "matrix.cpp"
+#include "task3.cpp"
 
 #endif /* matrix_hpp */
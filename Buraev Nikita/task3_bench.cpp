@@ -0,0 +1,115 @@
+// Flat Matrix<Type> against the former vector<vector<Type>> loops.
+// Build: g++ -std=c++17 -O2 task3_bench.cpp -o task3_bench
+// Run:   ./task3_bench [max_size]   (sizes 64, 128, ... up to max_size, 2048 by default)
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include "task3.hpp"
+
+typedef std::vector< std::vector<double> > Nested;
+
+static double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Repeats fn until at least 0.2 s have passed, returns seconds per call
+template <typename Fn>
+static double time_it(Fn fn)
+{
+    unsigned calls = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    do
+    {
+        fn();
+        ++calls;
+    } while (seconds_since(start) < 0.2);
+
+    return seconds_since(start) / calls;
+}
+
+static Nested nested_sum(const Nested &a, const Nested &b)
+{
+    Nested c(a.size(), std::vector<double>(a[0].size()));
+
+    for (std::size_t i = 0; i < a.size(); ++i)
+        for (std::size_t j = 0; j < a[0].size(); ++j)
+            c[i][j] = a[i][j] + b[i][j];
+
+    return c;
+}
+
+static Nested nested_product(const Nested &a, const Nested &b)
+{
+    Nested c(a.size(), std::vector<double>(b[0].size()));
+
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+        for (std::size_t j = 0; j < b[0].size(); ++j)
+        {
+            double sum = 0;
+
+            for (std::size_t k = 0; k < b.size(); ++k)
+                sum += a[i][k] * b[k][j];
+
+            c[i][j] = sum;
+        }
+    }
+
+    return c;
+}
+
+static Nested nested_transpose(const Nested &a)
+{
+    Nested c(a[0].size(), std::vector<double>(a.size()));
+
+    for (std::size_t i = 0; i < a.size(); ++i)
+        for (std::size_t j = 0; j < a[0].size(); ++j)
+            c[j][i] = a[i][j];
+
+    return c;
+}
+
+int main(int argc, char **argv)
+{
+    std::size_t max_size = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 2048;
+
+    std::cout << std::setw(6) << "n" << std::setw(12) << "op" << std::setw(14) << "nested, s"
+              << std::setw(14) << "flat, s" << std::setw(10) << "speedup" << std::endl;
+
+    for (std::size_t n = 64; n <= max_size; n *= 2)
+    {
+        Nested na(n, std::vector<double>(n)), nb(n, std::vector<double>(n));
+        Matrix<double> fa(n, n, 0.0), fb(n, n, 0.0);
+
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            for (std::size_t j = 0; j < n; ++j)
+            {
+                na[i][j] = fa(i, j) = double((i * 7 + j * 3) % 17) - 8;
+                nb[i][j] = fb(i, j) = double((i * 5 + j * 11) % 13) - 6;
+            }
+        }
+
+        double results[3][2] = {
+            {time_it([&] { nested_sum(na, nb); }), time_it([&] { fa + fb; })},
+            {time_it([&] { nested_product(na, nb); }), time_it([&] { fa * fb; })},
+            {time_it([&] { nested_transpose(na); }), time_it([&] { fa.transpose(); })},
+        };
+        const char *names[3] = {"operator+", "operator*", "transpose"};
+
+        for (int op = 0; op < 3; ++op)
+        {
+            std::cout << std::setw(6) << n << std::setw(12) << names[op]
+                      << std::setw(14) << results[op][0] << std::setw(14) << results[op][1]
+                      << std::setw(9) << std::fixed << std::setprecision(1) << results[op][0] / results[op][1] << "x"
+                      << std::defaultfloat << std::setprecision(6) << std::endl;
+        }
+    }
+
+    return 0;
+}
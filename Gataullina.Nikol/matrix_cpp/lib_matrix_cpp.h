@@ -4,6 +4,7 @@
 #include <windows.h>
 #include <cmath>
 #include <stdexcept>
+#include <vector>
 const double EPS = 1e-6;
 
 
@@ -22,6 +23,40 @@ Matrix_Exception MULTIPLYERROR("Error: first matrix cols not equal to the second
 Matrix_Exception ZERODIVISION("Error: divide by zero\n");
 Matrix_Exception MEM_ERROR("Error: memory is not allocated\n");
 Matrix_Exception EMPTY_MATRIX("Error: Function can't return an empty matrix\n");
+Matrix_Exception OUT_OF_RANGE("Error: the view does not fit into the matrix\n");
+
+
+class Matrix;
+
+
+// Block or minor of a matrix without copying its elements: only the row and
+// column indices are kept, so a minor of a minor costs O(n), not O(n^2).
+// The view must not outlive the matrix it was taken from.
+class Matrix_View
+{
+private:
+    const double *data;
+    size_t rows;
+    size_t cols;
+    std::vector<size_t> row_offset; // index in data of the first element of each row
+    std::vector<size_t> col_index;
+
+    Matrix_View(const double *, size_t, size_t);
+
+public:
+    Matrix_View(const Matrix &);
+
+    size_t get_row() const;
+    size_t get_col() const;
+    double at(const size_t, const size_t) const;
+
+    Matrix_View block(const size_t, const size_t, const size_t, const size_t) const;
+    Matrix_View minor(const size_t, const size_t) const;
+    Matrix materialize() const;
+
+    double determinant() const;
+    Matrix operator*(const Matrix_View &) const;
+};
 
 
 class Matrix
@@ -73,6 +108,7 @@ public:
     bool operator!=(const Matrix &);
     bool operator==(const Matrix &);
     friend std::ostream &operator<<(std::ostream &, const Matrix);
+    friend class Matrix_View;
 };
 
 
@@ -208,18 +244,7 @@ Matrix Matrix::matrix_minor(const unsigned int minor_row, const unsigned int min
     {
         throw EMPTY_MATRIX;
     }
-    Matrix minor(this->rows - 1, this->cols - 1);
-    unsigned int minor_index = 0;
-    for (unsigned int row = 0; row < this->rows; row++)
-    {
-        for (unsigned int col = 0; col < this->cols; col++)
-        {
-            if (row == minor_row || col == minor_col)
-                continue;
-            minor.data[minor_index++] = this->data[row * this->cols + col];
-        }
-    }
-    return minor;
+    return Matrix_View(*this).minor(minor_row, minor_col).materialize();
 }
 
 void Matrix::operator+=(const Matrix &matrix)
@@ -261,22 +286,7 @@ void Matrix::operator/=(const double k)
 
 void Matrix::operator*=(const Matrix &matrix)
 {
-    if (this->cols != matrix.rows)
-        throw MULTIPLYERROR;
-    Matrix multiplication(this->rows, matrix.cols);
-    for (unsigned int row = 0; row < multiplication.rows; row++)
-    {
-        for (unsigned int col = 0; col < multiplication.cols; col++)
-        {
-            double sum = 0;
-            for (unsigned int k = 0; k < matrix.rows; k++)
-            {
-                sum += data[row * cols + k] * matrix.data[k * matrix.cols + col];
-            }
-            multiplication.data[row * multiplication.cols + col] = sum;
-        }
-    }
-    *this = multiplication;
+    *this = Matrix_View(*this) * Matrix_View(matrix);
 }
 
 
@@ -344,52 +354,152 @@ Matrix Matrix::operator/(const double k)
 }
 
 
-double Matrix::matrix_determinant(const Matrix *matrix) // Из-за рекурсии принимает снова себя
+double Matrix::matrix_determinant(const Matrix *matrix)
 {
-    if (matrix->rows != matrix->cols)
-        throw NOTSQUARE;
-    double det = 0;
-    int k = 1;
-    if (matrix->rows == 0)
-        return 0;
-    if (matrix->rows == 1)
-        return matrix->data[0];
-    if (matrix->rows == 2)
-    {
-        return (matrix->data[0] * matrix->data[3] - matrix->data[2] * matrix->data[1]);
-    }
-    for (unsigned int idx = 0; idx < matrix->cols; idx++)
-    {
-        Matrix temp = matrix_minor(0, idx);
-        det += k * matrix->data[idx] * matrix_determinant(&temp);
-        k = -k;
-    }
-    return det;
+    return Matrix_View(*matrix).determinant();
 }
 
-Matrix Matrix::matrix_reverse(const Matrix *matrix) // Из-за рекурсии принимает снова себя
+Matrix Matrix::matrix_reverse(const Matrix *matrix)
 { 
-    double d = matrix_determinant(matrix);
     if (matrix->rows != matrix->cols)
         throw NOTSQUARE;
+    Matrix_View view(*matrix);
+    double d = view.determinant();
     if (fabs(d) < EPS)
         throw ZERODIVISION;
     Matrix reverse(matrix->rows, matrix->cols);
-    int k = 1;
     for (unsigned int row = 0; row < reverse.rows; row++)
     {
         for (unsigned int col = 0; col < reverse.cols; col++)
         {
-            Matrix temp = matrix_minor(row, col);
-            reverse.data[row * matrix->cols + col] = k * matrix_determinant(&temp);
-            k = -k;
+            int k = ((row + col) % 2 == 0) ? 1 : -1;
+            reverse.data[col * reverse.cols + row] = k * view.minor(row, col).determinant() / d;
         }
     }
-    reverse.matrix_transpose();
-    reverse /= d;
     return reverse;
 }
 
+Matrix_View::Matrix_View(const double *data, size_t num_row, size_t num_col)
+    : data(data), rows(num_row), cols(num_col), row_offset(num_row), col_index(num_col) {}
+
+Matrix_View::Matrix_View(const Matrix &matrix) : Matrix_View(matrix.data, matrix.rows, matrix.cols)
+{
+    for (size_t row = 0; row < this->rows; row++)
+    {
+        this->row_offset[row] = row * matrix.cols;
+    }
+    for (size_t col = 0; col < this->cols; col++)
+    {
+        this->col_index[col] = col;
+    }
+}
+
+size_t Matrix_View::get_row() const
+{
+    return (this->rows);
+}
+
+size_t Matrix_View::get_col() const
+{
+    return (this->cols);
+}
+
+double Matrix_View::at(const size_t row, const size_t col) const
+{
+    return this->data[this->row_offset[row] + this->col_index[col]];
+}
+
+Matrix_View Matrix_View::block(const size_t first_row, const size_t num_row, const size_t first_col, const size_t num_col) const
+{
+    if (first_row + num_row > this->rows || first_col + num_col > this->cols)
+        throw OUT_OF_RANGE;
+    Matrix_View view(this->data, num_row, num_col);
+    for (size_t row = 0; row < num_row; row++)
+    {
+        view.row_offset[row] = this->row_offset[first_row + row];
+    }
+    for (size_t col = 0; col < num_col; col++)
+    {
+        view.col_index[col] = this->col_index[first_col + col];
+    }
+    return view;
+}
+
+Matrix_View Matrix_View::minor(const size_t minor_row, const size_t minor_col) const
+{
+    if (this->rows == 0 || this->cols == 0)
+        throw EMPTY_MATRIX;
+    if (minor_row >= this->rows || minor_col >= this->cols)
+        throw OUT_OF_RANGE;
+    Matrix_View view(this->data, this->rows - 1, this->cols - 1);
+    for (size_t row = 0; row < view.rows; row++)
+    {
+        view.row_offset[row] = this->row_offset[row < minor_row ? row : row + 1];
+    }
+    for (size_t col = 0; col < view.cols; col++)
+    {
+        view.col_index[col] = this->col_index[col < minor_col ? col : col + 1];
+    }
+    return view;
+}
+
+Matrix Matrix_View::materialize() const
+{
+    Matrix copy(this->rows, this->cols);
+    for (size_t row = 0; row < this->rows; row++)
+    {
+        for (size_t col = 0; col < this->cols; col++)
+        {
+            copy.data[row * copy.cols + col] = this->at(row, col);
+        }
+    }
+    return copy;
+}
+
+double Matrix_View::determinant() const
+{
+    if (this->rows != this->cols)
+        throw NOTSQUARE;
+    if (this->rows == 0)
+        return 0;
+    if (this->rows == 1)
+        return this->at(0, 0);
+    if (this->rows == 2)
+    {
+        return (this->at(0, 0) * this->at(1, 1) - this->at(1, 0) * this->at(0, 1));
+    }
+    double det = 0;
+    int k = 1;
+    for (size_t idx = 0; idx < this->cols; idx++)
+    {
+        det += k * this->at(0, idx) * this->minor(0, idx).determinant();
+        k = -k;
+    }
+    return det;
+}
+
+Matrix Matrix_View::operator*(const Matrix_View &B) const
+{
+    if (this->cols != B.rows)
+        throw MULTIPLYERROR;
+    Matrix multiplication(this->rows, B.cols);
+    multiplication.matrix_zero();
+    for (size_t row = 0; row < this->rows; row++)
+    {
+        double *out = multiplication.data + row * multiplication.cols;
+        for (size_t k = 0; k < this->cols; k++)
+        {
+            double a = this->at(row, k);
+            const double *b = B.data + B.row_offset[k];
+            for (size_t col = 0; col < B.cols; col++)
+            {
+                out[col] += a * b[B.col_index[col]];
+            }
+        }
+    }
+    return multiplication;
+}
+
 Matrix Matrix::sum_for_exp(const size_t accuracy)
 {
     Matrix E = Matrix(this->rows, this->cols);
@@ -0,0 +1,445 @@
+#include <math.h>
+#include <algorithm>
+#include <cstring>
+#include "batch.hpp"
+
+namespace {
+
+// Matrices processed together; keeps a chunk of every scratch array in cache.
+constexpr size_t BATCH_CHUNK = 64;
+
+// Element (row, col) of a rows x cols operand lives at p + (row * cols + col) * ld,
+// followed by the same element of the next len - 1 matrices.
+void lanes_gemm(size_t m, size_t k, size_t n, size_t len,
+                MatrixItem alpha, const MatrixItem* a, size_t lda,
+                const MatrixItem* b, size_t ldb,
+                MatrixItem beta, MatrixItem* c, size_t ldc)
+{
+    for (size_t row = 0; row < m; row++) {
+        for (size_t col = 0; col < n; col++) {
+            MatrixItem* c_lane = c + (row * n + col) * ldc;
+
+            if (beta == 0.0)
+                std::fill(c_lane, c_lane + len, 0.0);
+            else if (beta != 1.0)
+                for (size_t l = 0; l < len; l++) c_lane[l] *= beta;
+
+            for (size_t idx = 0; idx < k; idx++) {
+                const MatrixItem* a_lane = a + (row * k + idx) * lda;
+                const MatrixItem* b_lane = b + (idx * n + col) * ldb;
+
+                for (size_t l = 0; l < len; l++)
+                    c_lane[l] += alpha * a_lane[l] * b_lane[l];
+            }
+        }
+    }
+}
+
+
+// Copies len matrices between two lane strides.
+void lanes_copy(size_t items, size_t len, const MatrixItem* src, size_t lds, MatrixItem* dst, size_t ldd)
+{
+    for (size_t idx = 0; idx < items; idx++)
+        memcpy(dst + idx * ldd, src + idx * lds, len * sizeof(MatrixItem));
+}
+
+
+void lanes_identity(size_t n, size_t len, MatrixItem* a, size_t lda)
+{
+    for (size_t row = 0; row < n; row++)
+        for (size_t col = 0; col < n; col++)
+            std::fill(a + (row * n + col) * lda, a + (row * n + col) * lda + len, (row == col) ? 1.0 : 0.0);
+}
+
+
+// Gaussian elimination with partial pivoting on n x n matrices a (destroyed),
+// lane stride BATCH_CHUNK. Row swaps are done as selects on every lane, so
+// matrices with different pivots still share one instruction stream.
+// det[l] receives the determinant; when x (n x nrhs) is given it is overwritten
+// with a^-1 x, NaN for singular matrices. Returns the number of singular ones.
+size_t lanes_eliminate(size_t n, size_t len, MatrixItem* a, MatrixItem* x, size_t nrhs, MatrixItem* det)
+{
+    const size_t ld = BATCH_CHUNK;
+    MatrixItem pivot[BATCH_CHUNK];
+    MatrixItem best[BATCH_CHUNK];
+    MatrixItem inv[BATCH_CHUNK];
+
+    auto at = [&](MatrixItem* p, size_t width, size_t row, size_t col) { return p + (row * width + col) * ld; };
+
+    std::fill(det, det + len, 1.0);
+
+    for (size_t k = 0; k < n; k++) {
+        const MatrixItem* diag = at(a, n, k, k);
+        for (size_t l = 0; l < len; l++) {
+            pivot[l] = (MatrixItem)k;
+            best[l] = fabs(diag[l]);
+        }
+
+        for (size_t row = k + 1; row < n; row++) {
+            const MatrixItem* cand = at(a, n, row, k);
+            for (size_t l = 0; l < len; l++) {
+                const bool larger = fabs(cand[l]) > best[l];
+                best[l] = larger ? fabs(cand[l]) : best[l];
+                pivot[l] = larger ? (MatrixItem)row : pivot[l];
+            }
+        }
+
+        for (size_t row = k + 1; row < n; row++) {
+            for (size_t l = 0; l < len; l++)
+                det[l] = (pivot[l] == row) ? -det[l] : det[l];
+
+            for (size_t col = k; col < n; col++) {
+                MatrixItem* top = at(a, n, k, col);
+                MatrixItem* other = at(a, n, row, col);
+                for (size_t l = 0; l < len; l++) {
+                    const MatrixItem t = top[l];
+                    const bool swap = pivot[l] == row;
+                    top[l] = swap ? other[l] : t;
+                    other[l] = swap ? t : other[l];
+                }
+            }
+
+            for (size_t col = 0; x != nullptr && col < nrhs; col++) {
+                MatrixItem* top = at(x, nrhs, k, col);
+                MatrixItem* other = at(x, nrhs, row, col);
+                for (size_t l = 0; l < len; l++) {
+                    const MatrixItem t = top[l];
+                    const bool swap = pivot[l] == row;
+                    top[l] = swap ? other[l] : t;
+                    other[l] = swap ? t : other[l];
+                }
+            }
+        }
+
+        for (size_t l = 0; l < len; l++) {
+            det[l] *= diag[l];
+            inv[l] = (diag[l] == 0.0) ? 0.0 : 1.0 / diag[l];
+        }
+
+        for (size_t row = k + 1; row < n; row++) {
+            MatrixItem* factor = at(a, n, row, k);
+            for (size_t l = 0; l < len; l++) factor[l] *= inv[l];
+
+            for (size_t col = k + 1; col < n; col++) {
+                MatrixItem* trg = at(a, n, row, col);
+                const MatrixItem* src = at(a, n, k, col);
+                for (size_t l = 0; l < len; l++) trg[l] -= factor[l] * src[l];
+            }
+
+            for (size_t col = 0; x != nullptr && col < nrhs; col++) {
+                MatrixItem* trg = at(x, nrhs, row, col);
+                const MatrixItem* src = at(x, nrhs, k, col);
+                for (size_t l = 0; l < len; l++) trg[l] -= factor[l] * src[l];
+            }
+        }
+    }
+
+    size_t singular = 0;
+    for (size_t l = 0; l < len; l++)
+        singular += (det[l] == 0.0);
+
+    if (x == nullptr)
+        return singular;
+
+    for (size_t k = n; k-- > 0;) {
+        const MatrixItem* diag = at(a, n, k, k);
+        for (size_t l = 0; l < len; l++)
+            inv[l] = (det[l] == 0.0) ? NAN : 1.0 / diag[l];
+
+        for (size_t col = 0; col < nrhs; col++) {
+            MatrixItem* trg = at(x, nrhs, k, col);
+
+            for (size_t idx = k + 1; idx < n; idx++) {
+                const MatrixItem* coef = at(a, n, k, idx);
+                const MatrixItem* src = at(x, nrhs, idx, col);
+                for (size_t l = 0; l < len; l++) trg[l] -= coef[l] * src[l];
+            }
+
+            for (size_t l = 0; l < len; l++) trg[l] *= inv[l];
+        }
+    }
+
+    return singular;
+}
+
+}
+
+
+MatrixBatch::MatrixBatch(const size_t count, const size_t rows, const size_t cols)
+    : count{count}, rows{rows}, cols{cols}, items(count * rows * cols, 0.0)
+{
+    if (rows == 0 || cols == 0)
+        throw WRONG_CONDITIONS;
+}
+
+
+size_t MatrixBatch::get_count() const
+{
+    return count;
+}
+
+
+size_t MatrixBatch::get_rows() const
+{
+    return rows;
+}
+
+
+size_t MatrixBatch::get_cols() const
+{
+    return cols;
+}
+
+
+MatrixItem* MatrixBatch::lane(const size_t row, const size_t col)
+{
+    return items.data() + (row * cols + col) * count;
+}
+
+
+const MatrixItem* MatrixBatch::lane(const size_t row, const size_t col) const
+{
+    return items.data() + (row * cols + col) * count;
+}
+
+
+MatrixItem& MatrixBatch::operator[](const size_t idx, const size_t row, const size_t col)
+{
+    if (idx >= count || row >= rows || col >= cols)
+        throw OUT_OF_RANGE;
+
+    return lane(row, col)[idx];
+}
+
+
+const MatrixItem& MatrixBatch::operator[](const size_t idx, const size_t row, const size_t col) const
+{
+    if (idx >= count || row >= rows || col >= cols)
+        throw OUT_OF_RANGE;
+
+    return lane(row, col)[idx];
+}
+
+
+void MatrixBatch::set(const size_t idx, const Matrix& A)
+{
+    if (idx >= count)
+        throw OUT_OF_RANGE;
+
+    if (A.get_rows() != rows || A.get_cols() != cols)
+        throw WRONG_CONDITIONS;
+
+    for (size_t row = 0; row < rows; row++)
+        for (size_t col = 0; col < cols; col++)
+            lane(row, col)[idx] = A[row, col];
+}
+
+
+Matrix MatrixBatch::get(const size_t idx) const
+{
+    if (idx >= count)
+        throw OUT_OF_RANGE;
+
+    Matrix A(rows, cols);
+
+    for (size_t row = 0; row < rows; row++)
+        for (size_t col = 0; col < cols; col++)
+            A[row, col] = lane(row, col)[idx];
+
+    return A;
+}
+
+
+void batch_gemm(MatrixItem alpha, const MatrixBatch& A, const MatrixBatch& B,
+                MatrixItem beta, MatrixBatch& C)
+{
+    if (A.get_count() != B.get_count() || A.get_count() != C.get_count())
+        throw WRONG_CONDITIONS;
+
+    if (A.get_cols() != B.get_rows() || C.get_rows() != A.get_rows() || C.get_cols() != B.get_cols())
+        throw WRONG_CONDITIONS;
+
+    if (&C == &A || &C == &B)
+        throw WRONG_CONDITIONS;
+
+    const size_t count = A.get_count();
+
+    for (size_t begin = 0; begin < count; begin += BATCH_CHUNK) {
+        const size_t len = std::min(BATCH_CHUNK, count - begin);
+        lanes_gemm(A.get_rows(), A.get_cols(), B.get_cols(), len,
+                   alpha, A.lane(0, 0) + begin, count,
+                   B.lane(0, 0) + begin, count,
+                   beta, C.lane(0, 0) + begin, count);
+    }
+}
+
+
+std::vector<MatrixItem> batch_det(const MatrixBatch& A)
+{
+    if (A.get_rows() != A.get_cols())
+        throw WRONG_CONDITIONS;
+
+    const size_t n = A.get_rows();
+    const size_t count = A.get_count();
+    std::vector<MatrixItem> det(count);
+    std::vector<MatrixItem> work(n * n * BATCH_CHUNK);
+
+    for (size_t begin = 0; begin < count; begin += BATCH_CHUNK) {
+        const size_t len = std::min(BATCH_CHUNK, count - begin);
+        lanes_copy(n * n, len, A.lane(0, 0) + begin, count, work.data(), BATCH_CHUNK);
+        lanes_eliminate(n, len, work.data(), nullptr, 0, det.data() + begin);
+    }
+
+    return det;
+}
+
+
+size_t batch_inverse(const MatrixBatch& A, MatrixBatch& Inv)
+{
+    if (A.get_rows() != A.get_cols() || Inv.get_rows() != A.get_rows() || Inv.get_cols() != A.get_cols())
+        throw WRONG_CONDITIONS;
+
+    if (A.get_count() != Inv.get_count())
+        throw WRONG_CONDITIONS;
+
+    const size_t n = A.get_rows();
+    const size_t count = A.get_count();
+    std::vector<MatrixItem> work(n * n * BATCH_CHUNK);
+    std::vector<MatrixItem> x(n * n * BATCH_CHUNK);
+    MatrixItem det[BATCH_CHUNK];
+    size_t singular = 0;
+
+    for (size_t begin = 0; begin < count; begin += BATCH_CHUNK) {
+        const size_t len = std::min(BATCH_CHUNK, count - begin);
+        lanes_copy(n * n, len, A.lane(0, 0) + begin, count, work.data(), BATCH_CHUNK);
+        lanes_identity(n, len, x.data(), BATCH_CHUNK);
+        singular += lanes_eliminate(n, len, work.data(), x.data(), n, det);
+        lanes_copy(n * n, len, x.data(), BATCH_CHUNK, Inv.lane(0, 0) + begin, count);
+    }
+
+    return singular;
+}
+
+
+void batch_expm(const MatrixBatch& A, MatrixBatch& E)
+{
+    if (A.get_rows() != A.get_cols() || E.get_rows() != A.get_rows() || E.get_cols() != A.get_cols())
+        throw WRONG_CONDITIONS;
+
+    if (A.get_count() != E.get_count())
+        throw WRONG_CONDITIONS;
+
+    static const double theta13 = 5.371920351148152e0;
+    static const double b[] = {64764752532480000.0, 32382376266240000.0, 7771770303897600.0,
+                               1187353796428800.0, 129060195264000.0, 10559470521600.0,
+                               670442572800.0, 33522128640.0, 1323241920.0,
+                               40840800.0, 960960.0, 16380.0, 182.0, 1.0};
+
+    const size_t n = A.get_rows();
+    const size_t count = A.get_count();
+    const size_t size = n * n * BATCH_CHUNK;
+    const size_t ld = BATCH_CHUNK;
+
+    std::vector<MatrixItem> scratch(8 * size);
+    MatrixItem* As = scratch.data();
+    MatrixItem* A2 = As + size;
+    MatrixItem* A4 = A2 + size;
+    MatrixItem* A6 = A4 + size;
+    MatrixItem* U = A6 + size;
+    MatrixItem* V = U + size;
+    MatrixItem* inner = V + size;
+    MatrixItem* odd = inner + size;
+
+    MatrixItem norm[BATCH_CHUNK];
+    MatrixItem scale[BATCH_CHUNK];
+    MatrixItem squarings[BATCH_CHUNK];
+    MatrixItem det[BATCH_CHUNK];
+
+    for (size_t begin = 0; begin < count; begin += BATCH_CHUNK) {
+        const size_t len = std::min(BATCH_CHUNK, count - begin);
+        lanes_copy(n * n, len, A.lane(0, 0) + begin, count, As, ld);
+
+        // 1-norm of every matrix, then its own number of squarings
+        std::fill(norm, norm + len, 0.0);
+        for (size_t col = 0; col < n; col++) {
+            MatrixItem sum[BATCH_CHUNK] = {};
+            for (size_t row = 0; row < n; row++) {
+                const MatrixItem* src = As + (row * n + col) * ld;
+                for (size_t l = 0; l < len; l++) sum[l] += fabs(src[l]);
+            }
+            for (size_t l = 0; l < len; l++) norm[l] = std::max(norm[l], sum[l]);
+        }
+
+        // Inf or NaN entries are not squared at all, their result is set to NaN below
+        MatrixItem max_squarings = 0;
+        for (size_t l = 0; l < len; l++) {
+            if (!isfinite(norm[l])) squarings[l] = 0.0;
+            else squarings[l] = (norm[l] > theta13) ? ceil(log2(norm[l] / theta13)) : 0.0;
+            scale[l] = ldexp(1.0, -(int)squarings[l]);
+            max_squarings = std::max(max_squarings, squarings[l]);
+        }
+
+        for (size_t idx = 0; idx < n * n; idx++)
+            for (size_t l = 0; l < len; l++) As[idx * ld + l] *= scale[l];
+
+        lanes_gemm(n, n, n, len, 1.0, As, ld, As, ld, 0.0, A2, ld);
+        lanes_gemm(n, n, n, len, 1.0, A2, ld, A2, ld, 0.0, A4, ld);
+        lanes_gemm(n, n, n, len, 1.0, A4, ld, A2, ld, 0.0, A6, ld);
+
+        // U = A (A6 (b13 A6 + b11 A4 + b9 A2) + b7 A6 + b5 A4 + b3 A2 + b1 I)
+        // V =    A6 (b12 A6 + b10 A4 + b8 A2) + b6 A6 + b4 A4 + b2 A2 + b0 I
+        for (size_t row = 0; row < n; row++) {
+            for (size_t col = 0; col < n; col++) {
+                const size_t at = (row * n + col) * ld;
+                const MatrixItem one = (row == col) ? 1.0 : 0.0;
+
+                for (size_t l = 0; l < len; l++) {
+                    inner[at + l] = b[13] * A6[at + l] + b[11] * A4[at + l] + b[9] * A2[at + l];
+                    odd[at + l] = b[7] * A6[at + l] + b[5] * A4[at + l] + b[3] * A2[at + l] + b[1] * one;
+                }
+            }
+        }
+        lanes_gemm(n, n, n, len, 1.0, A6, ld, inner, ld, 1.0, odd, ld);
+        lanes_gemm(n, n, n, len, 1.0, As, ld, odd, ld, 0.0, U, ld);
+
+        for (size_t row = 0; row < n; row++) {
+            for (size_t col = 0; col < n; col++) {
+                const size_t at = (row * n + col) * ld;
+                const MatrixItem one = (row == col) ? 1.0 : 0.0;
+
+                for (size_t l = 0; l < len; l++) {
+                    inner[at + l] = b[12] * A6[at + l] + b[10] * A4[at + l] + b[8] * A2[at + l];
+                    V[at + l] = b[6] * A6[at + l] + b[4] * A4[at + l] + b[2] * A2[at + l] + b[0] * one;
+                }
+            }
+        }
+        lanes_gemm(n, n, n, len, 1.0, A6, ld, inner, ld, 1.0, V, ld);
+
+        // r(A) = (V - U)^-1 (V + U), solved in place into P = A2
+        MatrixItem* P = A2;
+        MatrixItem* Q = A4;
+        for (size_t idx = 0; idx < n * n; idx++) {
+            for (size_t l = 0; l < len; l++) {
+                P[idx * ld + l] = V[idx * ld + l] + U[idx * ld + l];
+                Q[idx * ld + l] = V[idx * ld + l] - U[idx * ld + l];
+            }
+        }
+        lanes_eliminate(n, len, Q, P, n, det);
+
+        // Every matrix is squared as often as its own norm needs; the rest keep their value
+        MatrixItem* R = P;
+        MatrixItem* next = A6;
+        for (size_t step = 0; step < (size_t)max_squarings; step++) {
+            lanes_gemm(n, n, n, len, 1.0, R, ld, R, ld, 0.0, next, ld);
+            for (size_t idx = 0; idx < n * n; idx++)
+                for (size_t l = 0; l < len; l++)
+                    R[idx * ld + l] = (step < squarings[l]) ? next[idx * ld + l] : R[idx * ld + l];
+        }
+
+        for (size_t l = 0; l < len; l++)
+            if (!isfinite(norm[l]))
+                for (size_t idx = 0; idx < n * n; idx++) R[idx * ld + l] = NAN;
+
+        lanes_copy(n * n, len, R, ld, E.lane(0, 0) + begin, count);
+    }
+}
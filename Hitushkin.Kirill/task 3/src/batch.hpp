@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include "matrix.hpp"
+
+// count matrices of the same rows x cols shape stored structure-of-arrays:
+// element (row, col) of every matrix lies in one contiguous lane of count
+// values. The batch kernels loop over that lane innermost, so each SIMD lane
+// works on a different matrix and nothing branches per matrix.
+class MatrixBatch
+{
+private:
+    size_t count;
+    size_t rows;
+    size_t cols;
+    std::vector<MatrixItem> items;
+
+public:
+    MatrixBatch(const size_t count, const size_t rows, const size_t cols);
+
+    size_t get_count() const;
+    size_t get_rows() const;
+    size_t get_cols() const;
+
+    // Element (row, col) of matrices 0 .. count - 1
+    MatrixItem* lane(const size_t row, const size_t col);
+    const MatrixItem* lane(const size_t row, const size_t col) const;
+
+    MatrixItem& operator[](const size_t idx, const size_t row, const size_t col);
+    const MatrixItem& operator[](const size_t idx, const size_t row, const size_t col) const;
+
+    void set(const size_t idx, const Matrix& A);
+    Matrix get(const size_t idx) const;
+};
+
+// C[i] = alpha * A[i] * B[i] + beta * C[i] for every i. C must not be A or B.
+void batch_gemm(MatrixItem alpha, const MatrixBatch& A, const MatrixBatch& B,
+                MatrixItem beta, MatrixBatch& C);
+
+// Determinants by partial-pivoting elimination, pivots chosen per matrix.
+std::vector<MatrixItem> batch_det(const MatrixBatch& A);
+
+// Inv[i] = A[i]^-1. Singular matrices get NaN inverses and are counted in the result.
+size_t batch_inverse(const MatrixBatch& A, MatrixBatch& Inv);
+
+// E[i] = exp(A[i]) with the degree 13 Pade approximant and a per-matrix
+// number of squarings, the same scheme as Matrix::expm() for large norms.
+// Matrices with Inf or NaN entries get NaN results.
+void batch_expm(const MatrixBatch& A, MatrixBatch& E);
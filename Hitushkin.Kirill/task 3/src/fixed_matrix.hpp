@@ -0,0 +1,311 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+#include "matrix.hpp"
+
+// Calls f(std::integral_constant<size_t, 0>{}) ... f(std::integral_constant<size_t, N - 1>{}),
+// so every loop over a FixedMatrix is unrolled by the compiler, not by the optimizer.
+template <size_t N, typename F>
+constexpr void static_for(F&& f)
+{
+    [&]<size_t... I>(std::index_sequence<I...>) {
+        (f(std::integral_constant<size_t, I>{}), ...);
+    }(std::make_index_sequence<N>{});
+}
+
+// R x C matrix with inline std::array storage, for the 3x3 and 4x4 transforms
+// that do not need the heap. Everything except the conversions to and from
+// Matrix is constexpr. Items are row-major, so view() hands them straight to
+// gemm with strides (C, 1).
+template <typename Item, size_t R, size_t C>
+class FixedMatrix
+{
+    static_assert(R > 0 && C > 0, "FixedMatrix needs at least one row and one column");
+
+private:
+    std::array<Item, R * C> items{};
+
+public:
+    constexpr FixedMatrix() = default;
+
+    constexpr FixedMatrix(std::initializer_list<Item> lst)
+    {
+        if (lst.size() != R * C)
+            throw OUT_OF_RANGE;
+
+        size_t idx = 0;
+        for (const Item& item : lst)
+            items[idx++] = item;
+    }
+
+    explicit FixedMatrix(const Matrix& A)
+    {
+        if (A.get_rows() != R || A.get_cols() != C)
+            throw WRONG_CONDITIONS;
+
+        static_for<R>([&](auto row) {
+            static_for<C>([&](auto col) { items[row * C + col] = static_cast<Item>(A[row, col]); });
+        });
+    }
+
+    explicit operator Matrix() const
+    {
+        Matrix A(R, C);
+
+        static_for<R>([&](auto row) {
+            static_for<C>([&](auto col) { A[row, col] = static_cast<MatrixItem>(items[row * C + col]); });
+        });
+
+        return A;
+    }
+
+    static constexpr FixedMatrix identity()
+        requires (R == C)
+    {
+        FixedMatrix A;
+        static_for<R>([&](auto idx) { A.items[idx * C + idx] = Item{1}; });
+        return A;
+    }
+
+    // Borrows the items for gemm and the view products, without a heap copy
+    MatrixView view() const
+        requires std::is_same_v<Item, MatrixItem>
+    {
+        return MatrixView(items.data(), R, C, C, 1);
+    }
+
+    static constexpr size_t get_rows() { return R; }
+    static constexpr size_t get_cols() { return C; }
+
+    constexpr Item* data() { return items.data(); }
+    constexpr const Item* data() const { return items.data(); }
+
+    constexpr Item& operator[](const size_t row, const size_t col) { return items[row * C + col]; }
+    constexpr const Item& operator[](const size_t row, const size_t col) const { return items[row * C + col]; }
+
+    constexpr bool operator==(const FixedMatrix& A) const { return items == A.items; }
+
+    constexpr FixedMatrix& operator+=(const FixedMatrix& A)
+    {
+        static_for<R * C>([&](auto idx) { items[idx] += A.items[idx]; });
+        return *this;
+    }
+
+    constexpr FixedMatrix& operator-=(const FixedMatrix& A)
+    {
+        static_for<R * C>([&](auto idx) { items[idx] -= A.items[idx]; });
+        return *this;
+    }
+
+    constexpr FixedMatrix& operator*=(const Item& factor)
+    {
+        static_for<R * C>([&](auto idx) { items[idx] *= factor; });
+        return *this;
+    }
+
+    constexpr FixedMatrix operator+(const FixedMatrix& A) const { return FixedMatrix(*this) += A; }
+    constexpr FixedMatrix operator-(const FixedMatrix& A) const { return FixedMatrix(*this) -= A; }
+    constexpr FixedMatrix operator*(const Item& factor) const { return FixedMatrix(*this) *= factor; }
+
+    template <size_t K>
+    constexpr FixedMatrix<Item, R, K> operator*(const FixedMatrix<Item, C, K>& A) const
+    {
+        FixedMatrix<Item, R, K> result;
+
+        static_for<R>([&](auto row) {
+            static_for<K>([&](auto col) {
+                Item sum{};
+                static_for<C>([&](auto idx) { sum += items[row * C + idx] * A[idx, col]; });
+                result[row, col] = sum;
+            });
+        });
+
+        return result;
+    }
+
+    constexpr FixedMatrix& operator*=(const FixedMatrix& A)
+        requires (R == C)
+    {
+        return *this = *this * A;
+    }
+
+    constexpr FixedMatrix<Item, C, R> T() const
+    {
+        FixedMatrix<Item, C, R> result;
+
+        static_for<R>([&](auto row) {
+            static_for<C>([&](auto col) { result[col, row] = items[row * C + col]; });
+        });
+
+        return result;
+    }
+
+    // Closed forms up to 4x4, partial-pivoting elimination above that
+    constexpr Item det() const
+        requires (R == C)
+    {
+        const FixedMatrix& a = *this;
+
+        if constexpr (R == 1) {
+            return a[0, 0];
+        } else if constexpr (R == 2) {
+            return a[0, 0] * a[1, 1] - a[0, 1] * a[1, 0];
+        } else if constexpr (R == 3) {
+            return a[0, 0] * (a[1, 1] * a[2, 2] - a[1, 2] * a[2, 1])
+                 - a[0, 1] * (a[1, 0] * a[2, 2] - a[1, 2] * a[2, 0])
+                 + a[0, 2] * (a[1, 0] * a[2, 1] - a[1, 1] * a[2, 0]);
+        } else if constexpr (R == 4) {
+            // Laplace expansion over the 2x2 minors of the top and bottom row pairs
+            const Item s0 = a[0, 0] * a[1, 1] - a[1, 0] * a[0, 1];
+            const Item s1 = a[0, 0] * a[1, 2] - a[1, 0] * a[0, 2];
+            const Item s2 = a[0, 0] * a[1, 3] - a[1, 0] * a[0, 3];
+            const Item s3 = a[0, 1] * a[1, 2] - a[1, 1] * a[0, 2];
+            const Item s4 = a[0, 1] * a[1, 3] - a[1, 1] * a[0, 3];
+            const Item s5 = a[0, 2] * a[1, 3] - a[1, 2] * a[0, 3];
+            const Item c5 = a[2, 2] * a[3, 3] - a[3, 2] * a[2, 3];
+            const Item c4 = a[2, 1] * a[3, 3] - a[3, 1] * a[2, 3];
+            const Item c3 = a[2, 1] * a[3, 2] - a[3, 1] * a[2, 2];
+            const Item c2 = a[2, 0] * a[3, 3] - a[3, 0] * a[2, 3];
+            const Item c1 = a[2, 0] * a[3, 2] - a[3, 0] * a[2, 2];
+            const Item c0 = a[2, 0] * a[3, 1] - a[3, 0] * a[2, 1];
+            return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+        } else {
+            FixedMatrix lu(*this);
+            Item result{1};
+
+            for (size_t col = 0; col < R; col++) {
+                size_t pivot = col;
+                for (size_t row = col + 1; row < R; row++)
+                    if (abs_value(lu[row, col]) > abs_value(lu[pivot, col]))
+                        pivot = row;
+
+                if (lu[pivot, col] == Item{0})
+                    return Item{0};
+
+                if (pivot != col) {
+                    for (size_t idx = 0; idx < R; idx++)
+                        std::swap(lu[pivot, idx], lu[col, idx]);
+                    result = -result;
+                }
+
+                result *= lu[col, col];
+                for (size_t row = col + 1; row < R; row++) {
+                    const Item factor = lu[row, col] / lu[col, col];
+                    for (size_t idx = col + 1; idx < R; idx++)
+                        lu[row, idx] -= factor * lu[col, idx];
+                }
+            }
+
+            return result;
+        }
+    }
+
+    // Adjugate over determinant up to 4x4, Gauss-Jordan above that.
+    // Throws WRONG_CONDITIONS for a singular matrix.
+    constexpr FixedMatrix inverse() const
+        requires (R == C)
+    {
+        const FixedMatrix& a = *this;
+        FixedMatrix inv;
+
+        if constexpr (R <= 4) {
+            const Item d = det();
+            if (d == Item{0})
+                throw WRONG_CONDITIONS;
+
+            if constexpr (R == 1) {
+                inv[0, 0] = Item{1} / d;
+            } else if constexpr (R == 2) {
+                inv = {a[1, 1], -a[0, 1], -a[1, 0], a[0, 0]};
+                inv *= Item{1} / d;
+            } else if constexpr (R == 3) {
+                inv = {a[1, 1] * a[2, 2] - a[1, 2] * a[2, 1], a[0, 2] * a[2, 1] - a[0, 1] * a[2, 2], a[0, 1] * a[1, 2] - a[0, 2] * a[1, 1],
+                       a[1, 2] * a[2, 0] - a[1, 0] * a[2, 2], a[0, 0] * a[2, 2] - a[0, 2] * a[2, 0], a[0, 2] * a[1, 0] - a[0, 0] * a[1, 2],
+                       a[1, 0] * a[2, 1] - a[1, 1] * a[2, 0], a[0, 1] * a[2, 0] - a[0, 0] * a[2, 1], a[0, 0] * a[1, 1] - a[0, 1] * a[1, 0]};
+                inv *= Item{1} / d;
+            } else {
+                const Item s0 = a[0, 0] * a[1, 1] - a[1, 0] * a[0, 1];
+                const Item s1 = a[0, 0] * a[1, 2] - a[1, 0] * a[0, 2];
+                const Item s2 = a[0, 0] * a[1, 3] - a[1, 0] * a[0, 3];
+                const Item s3 = a[0, 1] * a[1, 2] - a[1, 1] * a[0, 2];
+                const Item s4 = a[0, 1] * a[1, 3] - a[1, 1] * a[0, 3];
+                const Item s5 = a[0, 2] * a[1, 3] - a[1, 2] * a[0, 3];
+                const Item c5 = a[2, 2] * a[3, 3] - a[3, 2] * a[2, 3];
+                const Item c4 = a[2, 1] * a[3, 3] - a[3, 1] * a[2, 3];
+                const Item c3 = a[2, 1] * a[3, 2] - a[3, 1] * a[2, 2];
+                const Item c2 = a[2, 0] * a[3, 3] - a[3, 0] * a[2, 3];
+                const Item c1 = a[2, 0] * a[3, 2] - a[3, 0] * a[2, 2];
+                const Item c0 = a[2, 0] * a[3, 1] - a[3, 0] * a[2, 1];
+
+                inv = { a[1, 1] * c5 - a[1, 2] * c4 + a[1, 3] * c3,
+                       -a[0, 1] * c5 + a[0, 2] * c4 - a[0, 3] * c3,
+                        a[3, 1] * s5 - a[3, 2] * s4 + a[3, 3] * s3,
+                       -a[2, 1] * s5 + a[2, 2] * s4 - a[2, 3] * s3,
+                       -a[1, 0] * c5 + a[1, 2] * c2 - a[1, 3] * c1,
+                        a[0, 0] * c5 - a[0, 2] * c2 + a[0, 3] * c1,
+                       -a[3, 0] * s5 + a[3, 2] * s2 - a[3, 3] * s1,
+                        a[2, 0] * s5 - a[2, 2] * s2 + a[2, 3] * s1,
+                        a[1, 0] * c4 - a[1, 1] * c2 + a[1, 3] * c0,
+                       -a[0, 0] * c4 + a[0, 1] * c2 - a[0, 3] * c0,
+                        a[3, 0] * s4 - a[3, 1] * s2 + a[3, 3] * s0,
+                       -a[2, 0] * s4 + a[2, 1] * s2 - a[2, 3] * s0,
+                       -a[1, 0] * c3 + a[1, 1] * c1 - a[1, 2] * c0,
+                        a[0, 0] * c3 - a[0, 1] * c1 + a[0, 2] * c0,
+                       -a[3, 0] * s3 + a[3, 1] * s1 - a[3, 2] * s0,
+                        a[2, 0] * s3 - a[2, 1] * s1 + a[2, 2] * s0};
+                inv *= Item{1} / d;
+            }
+        } else {
+            FixedMatrix work(*this);
+            inv = identity();
+
+            for (size_t col = 0; col < R; col++) {
+                size_t pivot = col;
+                for (size_t row = col + 1; row < R; row++)
+                    if (abs_value(work[row, col]) > abs_value(work[pivot, col]))
+                        pivot = row;
+
+                if (work[pivot, col] == Item{0})
+                    throw WRONG_CONDITIONS;
+
+                for (size_t idx = 0; idx < R; idx++) {
+                    std::swap(work[pivot, idx], work[col, idx]);
+                    std::swap(inv[pivot, idx], inv[col, idx]);
+                }
+
+                const Item scale = Item{1} / work[col, col];
+                for (size_t idx = 0; idx < R; idx++) {
+                    work[col, idx] *= scale;
+                    inv[col, idx] *= scale;
+                }
+
+                for (size_t row = 0; row < R; row++) {
+                    if (row == col) continue;
+                    const Item factor = work[row, col];
+                    for (size_t idx = 0; idx < R; idx++) {
+                        work[row, idx] -= factor * work[col, idx];
+                        inv[row, idx] -= factor * inv[col, idx];
+                    }
+                }
+            }
+        }
+
+        return inv;
+    }
+
+private:
+    static constexpr Item abs_value(const Item& x) { return (x < Item{0}) ? -x : x; }
+};
+
+template <typename Item, size_t R, size_t C>
+constexpr FixedMatrix<Item, R, C> operator*(const Item& factor, const FixedMatrix<Item, R, C>& A)
+{
+    return A * factor;
+}
+
+typedef FixedMatrix<MatrixItem, 3, 3> Matrix3;
+typedef FixedMatrix<MatrixItem, 4, 4> Matrix4;
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <vector>
+#include "gemm.hpp"
+
+namespace {
+
+// Register tile of the micro-kernel: MR x NR accumulators.
+constexpr size_t MR = 4;
+constexpr size_t NR = 8;
+
+// Cache tiles: a KC x NR sliver of B stays in L1,
+// the MC x KC block of A in L2, the KC x NC panel of B in L3.
+constexpr size_t MC = 128;
+constexpr size_t KC = 256;
+constexpr size_t NC = 2048;
+
+// Below this amount of work packing costs more than it saves.
+constexpr size_t SMALL_WORK = 32 * 32 * 32;
+
+// Reused between calls so that repeated products do not allocate.
+thread_local std::vector<MatrixItem> packed_a;
+thread_local std::vector<MatrixItem> packed_b;
+
+
+void scale(size_t m, size_t n, MatrixItem beta, MatrixItem* c, size_t rsc, size_t csc)
+{
+    if (beta == 1.0)
+        return;
+
+    for (size_t i = 0; i < m; i++) {
+        for (size_t j = 0; j < n; j++) {
+            MatrixItem& item = c[i * rsc + j * csc];
+            item = (beta == 0.0) ? 0.0 : item * beta;
+        }
+    }
+}
+
+
+void gemm_small(size_t m, size_t n, size_t k, MatrixItem alpha,
+                const MatrixItem* a, size_t rsa, size_t csa,
+                const MatrixItem* b, size_t rsb, size_t csb,
+                MatrixItem* c, size_t rsc, size_t csc)
+{
+    for (size_t i = 0; i < m; i++) {
+        for (size_t p = 0; p < k; p++) {
+            MatrixItem factor = alpha * a[i * rsa + p * csa];
+
+            for (size_t j = 0; j < n; j++)
+                c[i * rsc + j * csc] += factor * b[p * rsb + j * csb];
+        }
+    }
+}
+
+
+// A block -> MR-row slivers, each stored column by column, zero padded.
+void pack_a(size_t mc, size_t kc, const MatrixItem* a, size_t rsa, size_t csa, MatrixItem* dst)
+{
+    for (size_t i = 0; i < mc; i += MR) {
+        size_t mr = std::min(MR, mc - i);
+
+        for (size_t p = 0; p < kc; p++) {
+            for (size_t ii = 0; ii < mr; ii++)
+                *dst++ = a[(i + ii) * rsa + p * csa];
+            for (size_t ii = mr; ii < MR; ii++)
+                *dst++ = 0.0;
+        }
+    }
+}
+
+
+// B panel -> NR-column slivers, each stored row by row, zero padded.
+void pack_b(size_t kc, size_t nc, const MatrixItem* b, size_t rsb, size_t csb, MatrixItem* dst)
+{
+    for (size_t j = 0; j < nc; j += NR) {
+        size_t nr = std::min(NR, nc - j);
+
+        for (size_t p = 0; p < kc; p++) {
+            for (size_t jj = 0; jj < nr; jj++)
+                *dst++ = b[p * rsb + (j + jj) * csb];
+            for (size_t jj = nr; jj < NR; jj++)
+                *dst++ = 0.0;
+        }
+    }
+}
+
+
+void micro_kernel(size_t kc, const MatrixItem* a, const MatrixItem* b, MatrixItem alpha,
+                  MatrixItem* c, size_t rsc, size_t csc, size_t mr, size_t nr)
+{
+    MatrixItem acc[MR][NR] = {};
+
+    for (size_t p = 0; p < kc; p++) {
+        for (size_t i = 0; i < MR; i++)
+            for (size_t j = 0; j < NR; j++)
+                acc[i][j] += a[i] * b[j];
+
+        a += MR;
+        b += NR;
+    }
+
+    if (mr == MR && nr == NR && csc == 1) {
+        for (size_t i = 0; i < MR; i++)
+            for (size_t j = 0; j < NR; j++)
+                c[i * rsc + j] += alpha * acc[i][j];
+        return;
+    }
+
+    for (size_t i = 0; i < mr; i++)
+        for (size_t j = 0; j < nr; j++)
+            c[i * rsc + j * csc] += alpha * acc[i][j];
+}
+
+} // namespace
+
+
+void gemm_kernel(size_t m, size_t n, size_t k,
+                 MatrixItem alpha,
+                 const MatrixItem* a, size_t rsa, size_t csa,
+                 const MatrixItem* b, size_t rsb, size_t csb,
+                 MatrixItem beta,
+                 MatrixItem* c, size_t rsc, size_t csc)
+{
+    if (m == 0 || n == 0)
+        return;
+
+    scale(m, n, beta, c, rsc, csc);
+
+    if (k == 0 || alpha == 0.0)
+        return;
+
+    if (m * n * k <= SMALL_WORK) {
+        gemm_small(m, n, k, alpha, a, rsa, csa, b, rsb, csb, c, rsc, csc);
+        return;
+    }
+
+    packed_a.resize(MC * KC);
+    packed_b.resize(KC * ((std::min(n, NC) + NR - 1) / NR) * NR);
+
+    for (size_t jc = 0; jc < n; jc += NC) {
+        size_t nc = std::min(NC, n - jc);
+
+        for (size_t pc = 0; pc < k; pc += KC) {
+            size_t kc = std::min(KC, k - pc);
+            pack_b(kc, nc, b + pc * rsb + jc * csb, rsb, csb, packed_b.data());
+
+            for (size_t ic = 0; ic < m; ic += MC) {
+                size_t mc = std::min(MC, m - ic);
+                pack_a(mc, kc, a + ic * rsa + pc * csa, rsa, csa, packed_a.data());
+
+                for (size_t jr = 0; jr < nc; jr += NR) {
+                    size_t nr = std::min(NR, nc - jr);
+
+                    for (size_t ir = 0; ir < mc; ir += MR) {
+                        size_t mr = std::min(MR, mc - ir);
+
+                        micro_kernel(kc, packed_a.data() + ir * kc, packed_b.data() + jr * kc, alpha,
+                                     c + (ic + ir) * rsc + (jc + jr) * csc, rsc, csc, mr, nr);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include "matrix.hpp"
+
+// Packed, cache-blocked C = alpha * A * B + beta * C.
+// Every operand is described by a base pointer and a row/column stride,
+// so transposed operands are just swapped strides.
+//
+// Blocking reorders the summation, so an element may differ from the
+// plain i-j-k loop by up to k * eps * sum(|a_ip| * |b_pj|).
+// With beta == 0 the old contents of C are never read.
+void gemm_kernel(size_t m, size_t n, size_t k,
+                 MatrixItem alpha,
+                 const MatrixItem* a, size_t rsa, size_t csa,
+                 const MatrixItem* b, size_t rsb, size_t csb,
+                 MatrixItem beta,
+                 MatrixItem* c, size_t rsc, size_t csc);
@@ -0,0 +1,254 @@
+#include <math.h>
+#include <algorithm>
+#include <cstring>
+#include "lu.hpp"
+#include "gemm.hpp"
+
+namespace {
+
+// Columns factored unblocked at a time; the trailing update is a GEMM.
+constexpr size_t LU_BLOCK = 64;
+
+}
+
+
+LU::LU(const Matrix& A)
+    : n{A.rows}, factors{A}, pivots(A.rows), sign{1}, singular{false}, norm1{0}
+{
+    if (A.rows != A.cols || A.items == nullptr)
+        throw WRONG_CONDITIONS;
+
+    for (size_t col = 0; col < n; col++) {
+        MatrixItem sum = 0;
+        for (size_t row = 0; row < n; row++)
+            sum += fabs(A.items[row * n + col]);
+        norm1 = std::max(norm1, sum);
+    }
+
+    factor();
+}
+
+
+// Unblocked elimination of columns [col0, col0 + width) over rows [col0, n).
+// Row swaps are applied to whole rows, so the left part stays consistent.
+void LU::factor_panel(size_t col0, size_t width)
+{
+    MatrixItem* a = factors.items;
+
+    for (size_t col = col0; col < col0 + width; col++) {
+        size_t pivot = col;
+
+        for (size_t row = col + 1; row < n; row++) {
+            if (fabs(a[row * n + col]) > fabs(a[pivot * n + col]))
+                pivot = row;
+        }
+
+        pivots[col] = pivot;
+
+        if (pivot != col) {
+            std::swap_ranges(a + col * n, a + (col + 1) * n, a + pivot * n);
+            sign = -sign;
+        }
+
+        if (a[col * n + col] == 0) {
+            singular = true;
+            continue;
+        }
+
+        for (size_t row = col + 1; row < n; row++) {
+            MatrixItem factor = a[row * n + col] /= a[col * n + col];
+
+            for (size_t idx = col + 1; idx < col0 + width; idx++)
+                a[row * n + idx] -= factor * a[col * n + idx];
+        }
+    }
+}
+
+
+// Right-looking blocked LU: factor a panel, solve for the block row of U,
+// then update the trailing matrix with one GEMM.
+void LU::factor()
+{
+    MatrixItem* a = factors.items;
+
+    for (size_t col0 = 0; col0 < n; col0 += LU_BLOCK) {
+        size_t width = std::min(LU_BLOCK, n - col0);
+        size_t rest = col0 + width;
+
+        factor_panel(col0, width);
+
+        if (rest == n)
+            break;
+
+        // U12 = L11^-1 * A12
+        for (size_t row = col0 + 1; row < rest; row++) {
+            for (size_t idx = col0; idx < row; idx++) {
+                MatrixItem factor = a[row * n + idx];
+
+                for (size_t col = rest; col < n; col++)
+                    a[row * n + col] -= factor * a[idx * n + col];
+            }
+        }
+
+        // A22 -= L21 * U12
+        gemm_kernel(n - rest, n - rest, width,
+                    -1.0,
+                    a + rest * n + col0, n, 1,
+                    a + col0 * n + rest, n, 1,
+                    1.0,
+                    a + rest * n + rest, n, 1);
+    }
+}
+
+
+double LU::det() const
+{
+    if (singular)
+        return 0.0;
+
+    double det = sign;
+
+    for (size_t idx = 0; idx < n; idx++)
+        det *= factors.items[idx * n + idx];
+
+    return det;
+}
+
+
+bool LU::is_singular() const
+{
+    return singular;
+}
+
+
+// x is n x nrhs, row-major; every step updates whole rows of right-hand sides.
+void LU::solve_in_place(MatrixItem* x, size_t nrhs) const
+{
+    const MatrixItem* a = factors.items;
+
+    for (size_t row = 0; row < n; row++) {
+        if (pivots[row] != row)
+            std::swap_ranges(x + row * nrhs, x + (row + 1) * nrhs, x + pivots[row] * nrhs);
+    }
+
+    for (size_t row = 1; row < n; row++) {
+        for (size_t idx = 0; idx < row; idx++) {
+            MatrixItem factor = a[row * n + idx];
+
+            for (size_t col = 0; col < nrhs; col++)
+                x[row * nrhs + col] -= factor * x[idx * nrhs + col];
+        }
+    }
+
+    for (size_t row = n; row-- > 0;) {
+        for (size_t idx = row + 1; idx < n; idx++) {
+            MatrixItem factor = a[row * n + idx];
+
+            for (size_t col = 0; col < nrhs; col++)
+                x[row * nrhs + col] -= factor * x[idx * nrhs + col];
+        }
+
+        MatrixItem diag = a[row * n + row];
+        for (size_t col = 0; col < nrhs; col++)
+            x[row * nrhs + col] /= diag;
+    }
+}
+
+
+// Solves A^T x = b: U^T w = b, L^T v = w, x = P^T v.
+void LU::solve_trans_vector(MatrixItem* x) const
+{
+    const MatrixItem* a = factors.items;
+
+    for (size_t row = 0; row < n; row++) {
+        for (size_t idx = 0; idx < row; idx++)
+            x[row] -= a[idx * n + row] * x[idx];
+        x[row] /= a[row * n + row];
+    }
+
+    for (size_t row = n; row-- > 0;) {
+        for (size_t idx = row + 1; idx < n; idx++)
+            x[row] -= a[idx * n + row] * x[idx];
+    }
+
+    for (size_t row = n; row-- > 0;)
+        std::swap(x[row], x[pivots[row]]);
+}
+
+
+Matrix LU::solve(const Matrix& B) const
+{
+    if (B.rows != n || B.items == nullptr)
+        throw WRONG_CONDITIONS;
+
+    if (singular)
+        throw WRONG_CONDITIONS;
+
+    Matrix X = B;
+    solve_in_place(X.items, X.cols);
+    return X;
+}
+
+
+Matrix LU::inverse() const
+{
+    Matrix E(n, n);
+    E.set_one();
+    return solve(E);
+}
+
+
+double LU::rcond() const
+{
+    if (singular || n == 0)
+        return 0.0;
+
+    std::vector<MatrixItem> x(n, 1.0 / n);
+    std::vector<MatrixItem> y(n);
+    std::vector<MatrixItem> z(n);
+    double estimate = 0;
+
+    for (size_t iter = 0; iter < 5; iter++) {
+        y = x;
+        solve_in_place(y.data(), 1);
+
+        estimate = 0;
+        for (size_t idx = 0; idx < n; idx++) {
+            estimate += fabs(y[idx]);
+            z[idx] = (y[idx] >= 0) ? 1.0 : -1.0;
+        }
+
+        solve_trans_vector(z.data());
+
+        size_t arg_max = 0;
+        MatrixItem z_dot_x = 0;
+        for (size_t idx = 0; idx < n; idx++) {
+            if (fabs(z[idx]) > fabs(z[arg_max]))
+                arg_max = idx;
+            z_dot_x += z[idx] * x[idx];
+        }
+
+        if (fabs(z[arg_max]) <= z_dot_x)
+            break;
+
+        std::fill(x.begin(), x.end(), 0.0);
+        x[arg_max] = 1.0;
+    }
+
+    if (estimate == 0 || norm1 == 0)
+        return 0.0;
+
+    return 1.0 / (norm1 * estimate);
+}
+
+
+const Matrix& LU::packed() const
+{
+    return factors;
+}
+
+
+const std::vector<size_t>& LU::pivot() const
+{
+    return pivots;
+}
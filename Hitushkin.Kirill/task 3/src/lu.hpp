@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include "matrix.hpp"
+
+// PA = LU with partial pivoting, factored once and reused by every query.
+// L (unit diagonal) and U are packed into one n x n matrix.
+class LU
+{
+private:
+    size_t n;
+    Matrix factors;
+    std::vector<size_t> pivots;  // at step k row k was swapped with pivots[k]
+    int sign;
+    bool singular;
+    MatrixItem norm1;  // of the original matrix, for rcond()
+
+    void factor_panel(size_t col0, size_t width);
+    void factor();
+
+    void solve_in_place(MatrixItem* x, size_t nrhs) const;
+    void solve_trans_vector(MatrixItem* x) const;
+
+public:
+    explicit LU(const Matrix& A);
+
+    double det() const;
+    bool is_singular() const;
+
+    Matrix solve(const Matrix& B) const;
+    Matrix inverse() const;
+
+    // Reciprocal condition number in the 1-norm, with ||A^-1|| estimated
+    // by Hager's method (a few O(n^2) solves instead of the inverse).
+    double rcond() const;
+
+    const Matrix& packed() const;
+    const std::vector<size_t>& pivot() const;
+};
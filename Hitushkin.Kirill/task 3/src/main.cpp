@@ -1,6 +1,12 @@
 #include <iostream>
 #include <string>
+#include <cmath>
 #include "matrix.hpp"
+#include "lu.hpp"
+#include "fixed_matrix.hpp"
+#include "batch.hpp"
+#include "sparse.hpp"
+#include "symmetric.hpp"
 
 
 void test(std::string name, bool success)
@@ -9,6 +15,29 @@ void test(std::string name, bool success)
     std::cout << ((success) ? "SUCCESS\n" : "FAIL\n");
 }
 
+// Plain i-j-k reference, compared within k * eps * sum(|a| * |b|)
+bool mult_matches_reference(const Matrix& A, const Matrix& B, const Matrix& AB)
+{
+    const double eps = 1e-16;
+
+    for (size_t row = 0; row < A.get_rows(); row++) {
+        for (size_t col = 0; col < B.get_cols(); col++) {
+            double sum = 0;
+            double bound = 0;
+
+            for (size_t idx = 0; idx < A.get_cols(); idx++) {
+                sum += A[row, idx] * B[idx, col];
+                bound += std::fabs(A[row, idx] * B[idx, col]);
+            }
+
+            if (std::fabs(AB[row, col] - sum) > A.get_cols() * eps * bound)
+                return false;
+        }
+    }
+
+    return true;
+}
+
 int main()
 {   
     Matrix A(3, 2);
@@ -44,12 +73,58 @@ int main()
     Matrix Mult = F * FF;
     test("Mult", Mult == ans_Mult);
 
+    Matrix G(2, 4);
+    G.set_zero();
+    Matrix FT = F.T();
+    Matrix FFT = FF.T();
+    gemm(1.0, FT, TRANS, FFT, TRANS, 0.0, G);
+    gemm(2.0, F, NO_TRANS, FF, NO_TRANS, -1.0, G);
+    test("Gemm", G == ans_Mult);
+
+    Matrix P(2, 2);
+    P = {2.5, 3, 4, 5};
+    P *= C;
+    test("Mult assign", P == B * C);
+
+    Matrix BigA(301, 517);
+    Matrix BigB(517, 263);
+    for (size_t row = 0; row < 301; row++)
+        for (size_t col = 0; col < 517; col++)
+            BigA[row, col] = std::sin(row * 0.37 + col * 1.3);
+    for (size_t row = 0; row < 517; row++)
+        for (size_t col = 0; col < 263; col++)
+            BigB[row, col] = std::cos(row * 0.11 - col * 0.7);
+    test("Mult big", mult_matches_reference(BigA, BigB, BigA * BigB));
+
     
     Matrix T(4, 2);
     T = {2, 6, 3, 7, 4, 8, 5, 9};
     Matrix ans_T(2, 4);
     ans_T = {2, 3, 4, 5, 6, 7, 8, 9};
     test("Tran", T.T() == ans_T);
+
+    Matrix BigT = BigA.T();
+    bool big_tran = BigT.get_rows() == 517 && BigT.get_cols() == 301;
+    for (size_t row = 0; big_tran && row < 301; row++)
+        for (size_t col = 0; col < 517; col++)
+            big_tran = big_tran && BigT[col, row] == BigA[row, col];
+    Matrix BigCycles = BigA;
+    Matrix Square(203, 203);
+    for (size_t row = 0; row < 203; row++)
+        for (size_t col = 0; col < 203; col++)
+            Square[row, col] = BigA[row, col];
+    Matrix SquareT = Square.T();
+    test("Tran big", big_tran && BigCycles.transpose() == BigT && Square.transpose() == SquareT);
+
+    MatrixView BigAT = BigA.T();
+    Matrix ViewProd = BigAT.T() * BigB;
+    Matrix Ref(BigA.get_cols(), BigA.get_cols());
+    gemm(1.0, BigA, TRANS, BigA, NO_TRANS, 0.0, Ref);
+    Matrix ViewGram = BigAT * BigA;
+    ViewGram -= Ref;
+    Matrix Owned = BigA.T();
+    test("Tran view", ViewProd == BigA * BigB && ViewGram.max() < 1e-9
+         && Owned == BigT && BigAT.get_data() == &BigA[0, 0]);
     
     
     Matrix D(3, 3);
@@ -57,10 +132,259 @@ int main()
     double ans_D = 2036;
     test("Det", (int)(D.det()*10) == ans_D);
 
+    LU luD(D);
+    Matrix E(3, 3);
+    E.set_one();
+    test("LU det", (int)(luD.det()*10) == ans_D);
+    Matrix DInv = D * luD.inverse();
+    DInv -= E;
+    test("LU inverse", DInv.max() < 1e-12);
+
+    Matrix BigX = BigA * BigB;
+    Matrix Sq(150, 150);
+    for (size_t row = 0; row < 150; row++)
+        for (size_t col = 0; col < 150; col++)
+            Sq[row, col] = BigX[row, col] + ((row == col) ? 50.0 : 0.0);
+    LU luSq(Sq);
+    Matrix Rhs(150, 4);
+    for (size_t row = 0; row < 150; row++)
+        for (size_t col = 0; col < 4; col++)
+            Rhs[row, col] = row * 0.5 - col;
+    Matrix Res = Sq * luSq.solve(Rhs);
+    Res -= Rhs;
+    test("LU solve", Res.max() < 1e-9 && luSq.rcond() > 0 && luSq.rcond() <= 1);
+
     Matrix ans_expm(3, 3);
     ans_expm = {1325081.25, 1594499.47, 1153925.02, 2100825.48, 2527969.84, 1829469.26, 1760956.08, 2118997.52, 1533499.65};
     Matrix EE = D.expm(0.01);
     test("Expm", EE == ans_expm);
+
+    Matrix Pade = D.expm();
+    Matrix Taylor = D.expm(1e-9);
+    Taylor -= Pade;
+    test("Expm pade", Taylor.max() < 1e-10 * Pade.max());
+
+    Matrix Rot(2, 2);
+    Rot = {0, 30, -30, 0};
+    Matrix ans_Rot(2, 2);
+    ans_Rot = {std::cos(30.0), std::sin(30.0), -std::sin(30.0), std::cos(30.0)};
+    Matrix RotE = Rot.expm();
+    RotE -= ans_Rot;
+    test("Expm pade large norm", RotE.max() < 1e-12);
+
+    Matrix Small(2, 2);
+    Small = {0.01, 0.02, -0.03, 0.001};
+    Matrix SmallE = Small.expm();
+    SmallE -= Small.expm(1e-18);
+    test("Expm pade small norm", SmallE.max() < 1e-15);
+
+    Matrix Inf(2, 2);
+    Inf = {1, INFINITY, 0, 1};
+    bool inf_thrown = false;
+    try {
+        Inf.expm();
+    } catch (const MatrixException&) {
+        inf_thrown = true;
+    }
+    MatrixBatch BN(2, 2, 2), BNE(2, 2, 2);
+    for (size_t row = 0; row < 2; row++)
+        for (size_t col = 0; col < 2; col++) {
+            BN[0, row, col] = Small[row, col];
+            BN[1, row, col] = (row == col) ? NAN : 0.0;
+        }
+    batch_expm(BN, BNE);
+    Matrix BNE0 = BNE.get(0);
+    BNE0 -= Small.expm();
+    test("Expm non-finite", inf_thrown && std::isnan(BNE[1, 0, 1]) && BNE0.max() < 1e-15);
+
+    constexpr Matrix3 Rot3 = {0, -1, 0, 1, 0, 0, 0, 0, 1};
+    static_assert(Rot3 * Rot3.T() == Matrix3::identity());
+    static_assert((Rot3 * Rot3).det() == 1);
+
+    Matrix3 D3(D);
+    test("Fixed det", std::fabs(D3.det() - D.det()) < 1e-12);
+    test("Fixed mult", Matrix(D3 * D3) == D * D);
+    test("Fixed tran", Matrix(D3.T()) == D.T());
+    Matrix D3Gemm(3, 3);
+    gemm(1.0, D3.view(), D3.view().T(), 0.0, D3Gemm);
+    test("Fixed view", Matrix(D3.view()) == D && D3.view() * D == D * D && D3Gemm == D * D.T());
+
+    Matrix4 Tr = {2, 0, 1, 3, 1, 4, 0, 1, 0, 2, 5, 1, 3, 1, 0, 6};
+    Matrix4 TrInv = Tr * Tr.inverse() - Matrix4::identity();
+    Matrix TrLU(Tr);
+    test("Fixed det 4x4", std::fabs(Tr.det() - LU(TrLU).det()) < 1e-12);
+    test("Fixed inverse 4x4", Matrix(TrInv).max() < 1e-12);
+
+    FixedMatrix<double, 5, 5> F5;
+    for (size_t row = 0; row < 5; row++)
+        for (size_t col = 0; col < 5; col++)
+            F5[row, col] = std::sin(row * 1.7 + col * 0.3) + ((row == col) ? 3.0 : 0.0);
+    Matrix F5Inv(F5 * F5.inverse() - FixedMatrix<double, 5, 5>::identity());
+    test("Fixed inverse 5x5", F5Inv.max() < 1e-12 && std::fabs(F5.det() - LU(Matrix(F5)).det()) < 1e-12);
+
+    // 150 matrices: one chunk and a partial one, sizes of the hot path
+    const size_t batch = 150;
+    bool batch_ok = true;
+    for (size_t n = 2; n <= 8; n += 3) {
+        MatrixBatch BA(batch, n, n), BB(batch, n, n), BC(batch, n, n), BI(batch, n, n), BE(batch, n, n);
+        for (size_t idx = 0; idx < batch; idx++)
+            for (size_t row = 0; row < n; row++)
+                for (size_t col = 0; col < n; col++) {
+                    BA[idx, row, col] = std::sin(idx * 0.9 + row * row * 1.3 + col * col * 0.4 + row * col) * (1 + idx % 7);
+                    BB[idx, row, col] = std::cos(idx * 0.2 - row * 0.5 + col * 1.1);
+                }
+        for (size_t col = 0; col < n; col++)
+            BA[7, n - 1, col] = BA[7, 0, col];
+
+        batch_gemm(1.0, BA, BB, 0.0, BC);
+        std::vector<MatrixItem> dets = batch_det(BA);
+        size_t singular = batch_inverse(BA, BI);
+        batch_expm(BA, BE);
+        batch_ok = batch_ok && singular == 1 && std::isnan(BI[7, 0, 0]);
+
+        for (size_t idx = 0; idx < batch; idx++) {
+            Matrix Ai = BA.get(idx);
+            Matrix Ci = BC.get(idx);
+            Ci -= Ai * BB.get(idx);
+            Matrix Ei = BE.get(idx);
+            Ei -= Ai.expm();
+            batch_ok = batch_ok && Ci.max() < 1e-12 && Ei.max() < 1e-11 * (1 + Ai.expm().max());
+            batch_ok = batch_ok && std::fabs(dets[idx] - LU(Ai).det()) < 1e-9 * (1 + std::fabs(dets[idx]));
+            if (idx == 7) continue;
+            Matrix Ii = Ai * BI.get(idx);
+            Matrix One(n, n);
+            One.set_one();
+            Ii -= One;
+            batch_ok = batch_ok && Ii.max() < 1e-9;
+        }
+    }
+    test("Batch", batch_ok);
+
+    // 0.3% dense with duplicate triplets; every product is checked against the dense kernels
+    const size_t sn = 700;
+    std::vector<Triplet> trips;
+    for (size_t idx = 0; idx < sn * 2; idx++)
+        trips.push_back({(idx * 7919) % sn, (idx * idx * 31 + 5) % sn, std::sin(idx * 0.3)});
+    trips.push_back({trips[0].row, trips[0].col, 1.5});
+    SparseMatrix SA(sn, sn, trips);
+    SparseMatrix SB = SA.T();
+    Matrix DA = SA.to_dense();
+    Matrix DB = DA.T();
+    Matrix DX(sn, 5);
+    for (size_t row = 0; row < sn; row++)
+        for (size_t col = 0; col < 5; col++)
+            DX[row, col] = std::cos(row * 0.01 + col);
+    std::vector<MatrixItem> x(sn);
+    for (size_t row = 0; row < sn; row++)
+        x[row] = DX[row, 0];
+
+    Matrix SpGemm = (SA * SB).to_dense();
+    SpGemm -= DA * DB;
+    Matrix SpDense = SA * DX;
+    SpDense -= DA * DX;
+    Matrix DenseSp = DX.T() * SB;
+    DenseSp -= DX.T() * DB;
+    std::vector<MatrixItem> y = SA * x;
+    Matrix DY = DA * DX;
+    bool sparse_ok = SA.nnz() < trips.size() && SA[trips[0].row, trips[0].col] == DA[trips[0].row, trips[0].col];
+    for (size_t row = 0; row < sn; row++)
+        sparse_ok = sparse_ok && std::fabs(y[row] - DY[row, 0]) < 1e-12;
+    sparse_ok = sparse_ok && SpGemm.max() < 1e-12 && SpDense.max() < 1e-12 && DenseSp.max() < 1e-12;
+    sparse_ok = sparse_ok && SparseMatrix(SA.to_columns()).to_dense() == DA && SparseMatrix(DA).nnz() == SA.nnz();
+
+    // Broken column structures are rejected instead of read out of bounds
+    SparseColumns bad_rows = SA.to_columns(), bad_order = SA.to_columns(), bad_count = SA.to_columns();
+    bad_rows.row_idx[0] = sn;
+    std::swap(bad_order.col_ptr[1], bad_order.col_ptr[sn / 2]);
+    bad_count.col_ptr.back()--;
+    for (const SparseColumns* bad : {&bad_rows, &bad_order, &bad_count}) {
+        bool thrown = false;
+        try {
+            SparseMatrix Bad(*bad);
+        } catch (const MatrixException&) {
+            thrown = true;
+        }
+        sparse_ok = sparse_ok && thrown;
+    }
+
+    // 100k x 100k second-difference operator, far beyond dense storage
+    const size_t big = 100000;
+    std::vector<Triplet> lap;
+    for (size_t row = 0; row < big; row++) {
+        lap.push_back({row, row, 2.0});
+        if (row > 0) lap.push_back({row, row - 1, -1.0});
+        if (row + 1 < big) lap.push_back({row, row + 1, -1.0});
+    }
+    SparseMatrix Lap(big, big, lap);
+    std::vector<MatrixItem> ones(big, 1.0);
+    std::vector<MatrixItem> lap_ones = Lap * ones;
+    SparseMatrix Lap2 = Lap * Lap;
+    sparse_ok = sparse_ok && lap_ones[0] == 1.0 && lap_ones[big / 2] == 0.0 && lap_ones[big - 1] == 1.0;
+    sparse_ok = sparse_ok && Lap2.nnz() == 5 * big - 6 && Lap2[500, 500] == 6.0 && Lap2[500, 502] == 1.0;
+    test("Sparse", sparse_ok);
+
+    SymmetricMatrix Gram = gram(BigA);
+    Matrix GramRef = BigA.T() * BigA;
+    bool gram_ok = Gram.get_size() == 517;
+    for (size_t row = 0; row < 517; row++)
+        for (size_t col = 0; col < 517; col++)
+            gram_ok = gram_ok && std::fabs(Gram[row, col] - GramRef[row, col]) < 1e-10;
+    Matrix GramT = gram(BigA.T()).to_dense();
+    GramT -= BigA * BigA.T();
+    gram_ok = gram_ok && GramT.max() < 1e-10;
+    test("Gram", gram_ok);
+
+    // BigA^T BigA has rank 301 < 517, so shift it to make it positive definite
+    SymmetricMatrix Spd = Gram;
+    for (size_t idx = 0; idx < 517; idx++)
+        Spd[idx, idx] += 1.0;
+    Cholesky chol(Spd);
+    Matrix SpdDense = Spd.to_dense();
+    Matrix SpdRhs(517, 3);
+    for (size_t row = 0; row < 517; row++)
+        for (size_t col = 0; col < 3; col++)
+            SpdRhs[row, col] = std::sin(row * 0.3 + col);
+    Matrix SpdRes = SpdDense * chol.solve(SpdRhs);
+    SpdRes -= SpdRhs;
+    SymmetricMatrix Indef(D + D.T());
+    Matrix IndefRes = Indef.to_dense() * Indef.solve(E);
+    IndefRes -= E;
+    test("Cholesky", chol.is_positive_definite() && SpdRes.max() < 1e-9
+         && std::fabs(chol.logdet() - std::log(std::fabs(LU(SpdDense).det()))) < 1e-8 * std::fabs(chol.logdet())
+         && std::fabs(Indef.det() - LU(D + D.T()).det()) < 1e-9 * std::fabs(Indef.det())
+         && !Cholesky(Indef).is_positive_definite() && IndefRes.max() < 1e-12);
+
+    // Zero diagonal, so Bunch-Kaufman needs 2x2 pivots and interchanges
+    const size_t kn = 201;
+    SymmetricMatrix Kkt(kn);
+    Matrix KktRhs(kn, 2);
+    for (size_t row = 0; row < kn; row++) {
+        for (size_t col = row + 1; col < kn; col++)
+            Kkt[row, col] = std::sin(row * 1.7 + col * 0.4) / (1.0 + col - row);
+        KktRhs[row, 0] = std::cos(row * 0.2);
+        KktRhs[row, 1] = 1.0;
+    }
+    Matrix KktDense = Kkt.to_dense();
+    Matrix KktRes = KktDense * Kkt.solve(KktRhs);
+    KktRes -= KktRhs;
+    double kkt_det = LU(KktDense).det();
+    bool ldlt_ok = BunchKaufman(Kkt).det() == Kkt.det() && std::fabs(Kkt.det() - kkt_det) < 1e-9 * std::fabs(kkt_det)
+                   && KktRes.max() < 1e-9;
+
+    // Writes drop the cached factorization
+    SymmetricMatrix Pair(2);
+    Pair[0, 1] = 2.0;
+    ldlt_ok = ldlt_ok && std::fabs(Pair.det() + 4.0) < 1e-15;
+    Pair[0, 0] = 5.0;
+    Pair[1, 1] = 1.0;
+    ldlt_ok = ldlt_ok && std::fabs(Pair.det() - 1.0) < 1e-14;
+    Pair[1, 1] = -1.0;
+    ldlt_ok = ldlt_ok && std::fabs(Pair.det() + 9.0) < 1e-14;
+    Pair[0, 1] = 1.0;
+    Pair[0, 0] = 1.0;
+    Pair[1, 1] = 1.0;
+    ldlt_ok = ldlt_ok && Pair.det() == 0.0 && BunchKaufman(Pair).is_singular();
+    test("Bunch-Kaufman", ldlt_ok);
     
     return 0;
 }
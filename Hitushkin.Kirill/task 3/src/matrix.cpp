@@ -4,16 +4,10 @@
 #include <string>
 #include <cstring>
 #include "matrix.hpp"
+#include "gemm.hpp"
+#include "lu.hpp"
+#include "transpose.hpp"
 
-// TODO Заменить char*
-class MatrixException : public std::exception {
-private:
-    const char* message;
-
-public:
-    MatrixException(std::string msg) : message(msg.c_str()) {}
-    const char* what () { return message; }
-};
 MatrixException OUT_OF_RANGE("out_of_range");
 MatrixException WRONG_CONDITIONS("wrong_conditions");
 MatrixException NO_MEMORY_ALLOCATED("no_memory_allocated");
@@ -55,6 +49,96 @@ Matrix::Matrix(Matrix&& A) : rows{A.rows}, cols{A.cols}, items{A.items}
 }
 
 
+Matrix::Matrix(const MatrixView& A)
+    : Matrix(A.get_rows(), A.get_cols())
+{
+    if (items == nullptr)
+        return;
+
+    const MatrixItem* src = A.get_data();
+
+    if (A.get_col_stride() == 1) {
+        for (size_t row = 0; row < rows; row++)
+            memcpy(items + row * cols, src + row * A.get_row_stride(), cols * sizeof(MatrixItem));
+    } else if (A.get_row_stride() == 1) {
+        // A transposed view of a dense block
+        transpose_kernel(cols, rows, src, A.get_col_stride(), items, cols);
+    } else {
+        for (size_t row = 0; row < rows; row++)
+            for (size_t col = 0; col < cols; col++)
+                items[row * cols + col] = A[row, col];
+    }
+}
+
+
+Matrix& Matrix::operator=(const MatrixView& A)
+{
+    Matrix copy(A);
+    return *this = std::move(copy);
+}
+
+
+bool Matrix::overlaps(const MatrixView& A) const
+{
+    const MatrixItem* data = A.get_data();
+    return items != nullptr && data >= items && data < items + rows * cols;
+}
+
+
+MatrixView::MatrixView(const Matrix& A)
+    : data{A.items}, rows{A.rows}, cols{A.cols}, row_stride{A.cols}, col_stride{1} {}
+
+
+MatrixView::MatrixView(const MatrixItem* data, const size_t rows, const size_t cols,
+                       const size_t row_stride, const size_t col_stride)
+    : data{data}, rows{rows}, cols{cols}, row_stride{row_stride}, col_stride{col_stride} {}
+
+
+const MatrixItem& MatrixView::operator[](const size_t row, const size_t col) const
+{
+    if (row >= rows || col >= cols)
+        throw OUT_OF_RANGE;
+
+    return data[row * row_stride + col * col_stride];
+}
+
+
+size_t MatrixView::get_rows() const
+{
+    return rows;
+}
+
+
+size_t MatrixView::get_cols() const
+{
+    return cols;
+}
+
+
+size_t MatrixView::get_row_stride() const
+{
+    return row_stride;
+}
+
+
+size_t MatrixView::get_col_stride() const
+{
+    return col_stride;
+}
+
+
+const MatrixItem* MatrixView::get_data() const
+{
+    return data;
+}
+
+
+MatrixView MatrixView::T() const
+{
+    return MatrixView(data, cols, rows, col_stride, row_stride);
+}
+
+
 void Matrix::set_null()
 {
     items = nullptr;
@@ -63,6 +147,19 @@ void Matrix::set_null()
 }
 
 
+void Matrix::reshape(const size_t a, const size_t b)
+{
+    if (a * b != rows * cols || items == nullptr) {
+        delete[] items;
+        items = nullptr;
+        items = new MatrixItem[a * b];
+    }
+
+    rows = a;
+    cols = b;
+}
+
+
 Matrix& Matrix::operator=(std::initializer_list<MatrixItem> lst) 
 {
     if (lst.size() != rows * cols) 
@@ -219,38 +316,83 @@ Matrix operator-(const Matrix& A, Matrix&& B)
 }
 
 
-Matrix& Matrix::mult_to(Matrix& trg, const Matrix& A) const
+void gemm(MatrixItem alpha, const Matrix& A, MatrixOp opA, const Matrix& B, MatrixOp opB,
+          MatrixItem beta, Matrix& C)
 {
-    for (size_t num_row = 0; num_row < rows; num_row++) {
-        for (size_t num_col = 0; num_col < A.cols; num_col++) {
-            MatrixItem sum = 0;
+    gemm(alpha, (opA == NO_TRANS) ? MatrixView(A) : A.T(),
+         (opB == NO_TRANS) ? MatrixView(B) : B.T(), beta, C);
+}
 
-            for (size_t num_sum = 0; num_sum < A.rows; num_sum++) {
-                sum += items[num_row * cols + num_sum] * A.items[num_sum * A.cols + num_col];
-            }
 
-            trg.items[num_row * trg.cols + num_col] = sum;
-        }
-    }
+void gemm(MatrixItem alpha, const MatrixView& A, const MatrixView& B,
+          MatrixItem beta, Matrix& C)
+{
+    if (C.overlaps(A) || C.overlaps(B))
+        throw WRONG_CONDITIONS;
 
+    if (A.get_cols() != B.get_rows() || C.rows != A.get_rows() || C.cols != B.get_cols())
+        throw WRONG_CONDITIONS;
+
+    gemm_kernel(A.get_rows(), B.get_cols(), A.get_cols(),
+                alpha,
+                A.get_data(), A.get_row_stride(), A.get_col_stride(),
+                B.get_data(), B.get_row_stride(), B.get_col_stride(),
+                beta,
+                C.items, C.cols, 1);
+}
+
+
+Matrix& Matrix::mult_to(Matrix& trg, const MatrixView& A, const MatrixView& B)
+{
+    gemm(1.0, A, B, 0.0, trg);
     return trg;
 }
 
 
 Matrix Matrix::operator*(const Matrix& A) const
 {  
-    if (cols != A.rows)
+    return MatrixView(*this) * MatrixView(A);
+}
+
+
+Matrix operator*(const MatrixView& A, const MatrixView& B)
+{
+    if (A.get_cols() != B.get_rows())
         throw WRONG_CONDITIONS;
-    
-    Matrix mult(rows, A.cols);
-    mult_to(mult, A);
+
+    Matrix mult(A.get_rows(), B.get_cols());
+    gemm(1.0, A, B, 0.0, mult);
     return mult;
 }
 
 
+Matrix operator*(const Matrix& A, const MatrixView& B)
+{
+    return MatrixView(A) * B;
+}
+
+
+Matrix operator*(const MatrixView& A, const Matrix& B)
+{
+    return A * MatrixView(B);
+}
+
+
 Matrix& Matrix::operator*=(const Matrix& A)
 {
-    *this = *this * A;
+    if (cols != A.rows)
+        throw WRONG_CONDITIONS;
+
+    // Product goes to a per-thread buffer that then trades storage with *this,
+    // so repeated same-shape products reuse the two allocations
+    thread_local Matrix scratch;
+    scratch.reshape(rows, A.cols);
+    mult_to(scratch, *this, A);
+
+    std::swap(items, scratch.items);
+    std::swap(rows, scratch.rows);
+    std::swap(cols, scratch.cols);
+
     return *this;
 }
 
@@ -272,63 +414,152 @@ Matrix Matrix::operator*(const MatrixItem& factor)
 }
 
 
-Matrix Matrix::T()
+MatrixView Matrix::T() const &
 {
-    Matrix trn(cols, rows);
+    return MatrixView(*this).T();
+}
 
-    for (size_t num_row = 0; num_row < cols; num_row++) 
-        for (size_t num_col = 0; num_col < rows; num_col++) 
-            trn.items[num_row * trn.cols + num_col] = items[num_col * cols + num_row];
 
-    return trn;
+Matrix Matrix::T() &&
+{
+    return Matrix(MatrixView(*this).T());
+}
+
+
+Matrix& Matrix::transpose()
+{
+    if (rows == cols)
+        transpose_square(rows, items);
+    else
+        transpose_cycles(rows, cols, items);
+
+    std::swap(rows, cols);
+
+    return *this;
 }
 
 
 double Matrix::det() const
 {
-    if (cols != rows) 
-        throw WRONG_CONDITIONS;
+    return LU(*this).det();
+}
 
-    if (items == nullptr)
+
+Matrix& Matrix::add_scaled(const MatrixItem& factor, const Matrix& A)
+{
+    if ((rows != A.rows) || (cols != A.cols))
         throw WRONG_CONDITIONS;
 
-    Matrix mat = *this;
+    for (size_t idx = 0; idx < (rows * cols); idx++)
+        items[idx] += factor * A.items[idx];
 
-    double det = 1.0;
-    int pivot = 0;
-    double factor = 0;
+    return *this;
+}
 
-    for (size_t num_col = 0; num_col < mat.cols; num_col++) {
-        pivot = num_col;
 
-        for (size_t num_row = num_col + 1; num_row < mat.rows; num_row++) {
-            if (fabs(mat.items[num_row * mat.cols + num_col]) > fabs(mat.items[pivot * mat.cols + num_col]))
-                pivot = num_row;
-        }
+Matrix Matrix::expm() const
+{
+    if (cols != rows) 
+        throw WRONG_CONDITIONS;
 
-        if (pivot != num_col) {
-            for (size_t idx = 0; idx < mat.rows; idx++) 
-                std::swap(mat.items[num_col * mat.cols + idx], mat.items[pivot * mat.cols + idx]);
+    if (items == nullptr)
+        throw WRONG_CONDITIONS;
 
-            det *= -1;
-        }
+    MatrixItem norm = norm1();
+    // Inf or NaN entries would turn the number of squarings into garbage;
+    // checked before any product is spent on them
+    if (!isfinite(norm))
+        throw WRONG_CONDITIONS;
 
-        if (mat.items[num_col * mat.cols + num_col] == 0) {
-            det = 0;
-            break;
+    // Largest 1-norm for which each degree keeps the backward error below 2^-53
+    static const size_t degrees[] = {3, 5, 7, 9};
+    static const double theta[] = {1.495585217958292e-2, 2.539398330063230e-1,
+                                   9.504178996162932e-1, 2.097847961257068e0};
+    static const double theta13 = 5.371920351148152e0;
+    static const double b[] = {64764752532480000.0, 32382376266240000.0, 7771770303897600.0,
+                               1187353796428800.0, 129060195264000.0, 10559470521600.0,
+                               670442572800.0, 33522128640.0, 1323241920.0,
+                               40840800.0, 960960.0, 16380.0, 182.0, 1.0};
+    static const double b_low[4][10] = {
+        {120.0, 60.0, 12.0, 1.0},
+        {30240.0, 15120.0, 3360.0, 420.0, 30.0, 1.0},
+        {17297280.0, 8648640.0, 1995840.0, 277200.0, 25200.0, 1512.0, 56.0, 1.0},
+        {17643225600.0, 8821612800.0, 2075673600.0, 302702400.0, 30270240.0,
+         2162160.0, 110880.0, 3960.0, 90.0, 1.0}};
+
+    Matrix E(rows, cols);
+    E.set_one();
+
+    Matrix U(rows, cols);
+    Matrix V(rows, cols);
+    Matrix odd(rows, cols);
+    Matrix A2(rows, cols);
+    gemm(1.0, *this, NO_TRANS, *this, NO_TRANS, 0.0, A2);
+
+    size_t squarings = 0;
+    size_t level = 0;
+
+    while (level < 4 && norm > theta[level])
+        level++;
+
+    if (level < 4) {
+        // U = A * sum b[2k+1] A^2k, V = sum b[2k] A^2k
+        const double* c = b_low[level];
+        Matrix power = E;
+        Matrix next(rows, cols);
+        odd.set_zero();
+        V.set_zero();
+
+        for (size_t k = 0; 2 * k <= degrees[level]; k++) {
+            V.add_scaled(c[2 * k], power);
+            odd.add_scaled(c[2 * k + 1], power);
+
+            if (2 * k + 2 <= degrees[level]) {
+                gemm(1.0, power, NO_TRANS, A2, NO_TRANS, 0.0, next);
+                std::swap(power.items, next.items);
+            }
         }
 
-        det *= mat.items[num_col * mat.cols + num_col];
+        gemm(1.0, *this, NO_TRANS, odd, NO_TRANS, 0.0, U);
+    } else {
+        squarings = (norm > theta13) ? (size_t)ceil(log2(norm / theta13)) : 0;
+        MatrixItem scale = ldexp(1.0, -(int)squarings);
+
+        Matrix A = *this;
+        A *= scale;
+        A2 *= scale * scale;
+        Matrix A4(rows, cols);
+        Matrix A6(rows, cols);
+        gemm(1.0, A2, NO_TRANS, A2, NO_TRANS, 0.0, A4);
+        gemm(1.0, A4, NO_TRANS, A2, NO_TRANS, 0.0, A6);
+
+        Matrix inner(rows, cols);
+        inner.set_zero();
+        inner.add_scaled(b[13], A6).add_scaled(b[11], A4).add_scaled(b[9], A2);
+        odd.set_zero();
+        odd.add_scaled(b[7], A6).add_scaled(b[5], A4).add_scaled(b[3], A2).add_scaled(b[1], E);
+        gemm(1.0, A6, NO_TRANS, inner, NO_TRANS, 1.0, odd);
+        gemm(1.0, A, NO_TRANS, odd, NO_TRANS, 0.0, U);
+
+        inner.set_zero();
+        inner.add_scaled(b[12], A6).add_scaled(b[10], A4).add_scaled(b[8], A2);
+        V.set_zero();
+        V.add_scaled(b[6], A6).add_scaled(b[4], A4).add_scaled(b[2], A2).add_scaled(b[0], E);
+        gemm(1.0, A6, NO_TRANS, inner, NO_TRANS, 1.0, V);
+    }
 
-        for (size_t num_row = num_col + 1; num_row < mat.rows; num_row++) {
-            factor = mat.items[num_row * mat.cols + num_col] / mat.items[num_col * mat.cols + num_col];
+    // r(A) = (V - U)^-1 (V + U)
+    Matrix P = V;
+    P += U;
+    V -= U;
+    Matrix R = LU(V).solve(P);
 
-            for (size_t idx = num_col + 1; idx < mat.cols; idx++)
-                mat.items[num_row * mat.cols + idx] -= factor * mat.items[num_col * mat.cols + idx];
-        }
+    for (size_t count = 0; count < squarings; count++) {
+        gemm(1.0, R, NO_TRANS, R, NO_TRANS, 0.0, P);
+        std::swap(R.items, P.items);
     }
 
-    return det;
+    return R;
 }
 
 
@@ -348,8 +579,7 @@ Matrix Matrix::expm(const MatrixItem& accuracy) const
     sum.set_one();
 
     for(size_t count = 1; count < 200; count++) {
-        term *= (1.0 / count);
-        mult_to(temp, term);
+        gemm(1.0 / count, *this, NO_TRANS, term, NO_TRANS, 0.0, temp);
         std::swap(term.items, temp.items);
 
         sum += term;
@@ -377,6 +607,21 @@ MatrixItem Matrix::max()
 }
 
 
+MatrixItem Matrix::norm1() const
+{
+    MatrixItem norm = 0;
+
+    for (size_t col = 0; col < cols; col++) {
+        MatrixItem sum = 0;
+        for (size_t row = 0; row < rows; row++)
+            sum += std::fabs(items[row * cols + col]);
+        if (sum > norm) norm = sum;
+    }
+
+    return norm;
+}
+
+
 MatrixItem* Matrix::begin() {return items;}
 MatrixItem* Matrix::end() {return items + rows * cols;}
 const MatrixItem* Matrix::begin() const {return items;}
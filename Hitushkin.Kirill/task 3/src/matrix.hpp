@@ -1,7 +1,57 @@
+#pragma once
+
 #include <initializer_list>
+#include <cstddef>
+#include <ostream>
+#include <exception>
+#include <string>
 
 typedef double MatrixItem;
 
+enum MatrixOp { NO_TRANS, TRANS };
+
+class MatrixException : public std::exception {
+private:
+    std::string message;
+
+public:
+    MatrixException(std::string msg) : message(msg) {}
+    const char* what() const noexcept override { return message.c_str(); }
+};
+extern MatrixException OUT_OF_RANGE;
+extern MatrixException WRONG_CONDITIONS;
+extern MatrixException NO_MEMORY_ALLOCATED;
+
+class Matrix;
+
+// Non-owning window on matrix items: element (row, col) is
+// data[row * row_stride + col * col_stride], so a transpose only swaps strides.
+// A view must not outlive the matrix it looks at.
+class MatrixView
+{
+private:
+    const MatrixItem* data;
+    size_t rows;
+    size_t cols;
+    size_t row_stride;
+    size_t col_stride;
+
+public:
+    MatrixView(const Matrix& A);
+    MatrixView(const MatrixItem* data, const size_t rows, const size_t cols,
+               const size_t row_stride, const size_t col_stride);
+
+    const MatrixItem& operator[](const size_t row, const size_t col) const;
+
+    size_t get_rows() const;
+    size_t get_cols() const;
+    size_t get_row_stride() const;
+    size_t get_col_stride() const;
+    const MatrixItem* get_data() const;
+
+    MatrixView T() const;
+};
+
 class Matrix
 {        
 private:
@@ -14,9 +64,12 @@ private:
     const MatrixItem* begin() const;
     const MatrixItem* end() const;
 
-    Matrix& mult_to(Matrix& trg, const Matrix& A) const;
+    static Matrix& mult_to(Matrix& trg, const MatrixView& A, const MatrixView& B);
+    bool overlaps(const MatrixView& A) const;
 
     void set_null();
+    Matrix& add_scaled(const MatrixItem& factor, const Matrix& A);
+    void reshape(const size_t a, const size_t b);
 
 public:
     Matrix();
@@ -30,6 +83,10 @@ public:
     Matrix(Matrix&& A);
     Matrix& operator=(Matrix&& A);
 
+    // The only places a view is copied into storage of its own
+    Matrix(const MatrixView& A);
+    Matrix& operator=(const MatrixView& A);
+
     void set_zero();
     void set_one();
     
@@ -48,19 +105,48 @@ public:
     Matrix operator*(const MatrixItem& factor);
     Matrix& operator*=(const MatrixItem& factor);
     
-    Matrix T();
+    // O(1) view; on a temporary the transpose is materialized so nothing dangles
+    MatrixView T() const &;
+    Matrix T() &&;
+    // Square matrices swap 4x4 tiles, rectangular ones follow permutation cycles
+    Matrix& transpose();
 
     double det() const;
 
+    // Scaling and squaring with a degree 3/5/7/9/13 Pade approximant (Higham, 2005).
+    // Throws WRONG_CONDITIONS for Inf or NaN entries.
+    Matrix expm() const;
+    // Taylor series summed until a term drops below accuracy, kept for comparison
     Matrix expm(const double& accuracy) const;
 
     bool operator==(const Matrix& A) const;
 
     MatrixItem max();
+    MatrixItem norm1() const;
 
     ~Matrix();
+
+    friend class LU;
+    friend class MatrixView;
+
+    friend void gemm(MatrixItem alpha, const MatrixView& A, const MatrixView& B,
+                     MatrixItem beta, Matrix& C);
 };
 
+// C = alpha * op(A) * op(B) + beta * C, written into the caller's C without allocating.
+// C must already have the result's shape and must not be A or B.
+void gemm(MatrixItem alpha, const Matrix& A, MatrixOp opA, const Matrix& B, MatrixOp opB,
+          MatrixItem beta, Matrix& C);
+
+// Same with views: their strides go straight to the packing routines.
+// C must not overlap A or B.
+void gemm(MatrixItem alpha, const MatrixView& A, const MatrixView& B,
+          MatrixItem beta, Matrix& C);
+
+Matrix operator*(const MatrixView& A, const MatrixView& B);
+Matrix operator*(const Matrix& A, const MatrixView& B);
+Matrix operator*(const MatrixView& A, const Matrix& B);
+
 Matrix operator+(const Matrix& A, const Matrix& B);
 Matrix operator+(const Matrix& A, Matrix&& B);
 
@@ -0,0 +1,459 @@
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include "sparse.hpp"
+
+namespace {
+
+// Least work (multiply-adds) worth handing to one more thread. Threads are
+// started per call, so each has to get well over a millisecond of work.
+constexpr size_t PARALLEL_GRAIN = 1 << 21;
+
+
+// Splits rows [0, cost.size() - 1) into chunks of roughly equal cost, where
+// cost is a prefix sum over rows, and runs body(begin, end) on each chunk in
+// its own thread. Small jobs stay on the calling thread.
+template <typename Body>
+void parallel_rows(const std::vector<size_t>& cost, Body body)
+{
+    const size_t rows = cost.size() - 1;
+    const size_t total = cost[rows];
+    size_t parts = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                    total / PARALLEL_GRAIN + 1);
+    parts = std::min(parts, std::max<size_t>(rows, 1));
+
+    if (parts <= 1) {
+        body(0, rows);
+        return;
+    }
+
+    std::vector<size_t> bounds(parts + 1, rows);
+    bounds[0] = 0;
+    for (size_t part = 1; part < parts; part++) {
+        size_t target = total / parts * part;
+        bounds[part] = std::lower_bound(cost.begin(), cost.end(), target) - cost.begin();
+        bounds[part] = std::clamp(bounds[part], bounds[part - 1], rows);
+    }
+
+    std::vector<std::thread> workers;
+    for (size_t part = 1; part < parts; part++)
+        workers.emplace_back(body, bounds[part], bounds[part + 1]);
+    body(bounds[0], bounds[1]);
+
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+
+std::vector<size_t> uniform_cost(size_t rows, size_t per_row)
+{
+    std::vector<size_t> cost(rows + 1);
+    for (size_t row = 0; row <= rows; row++)
+        cost[row] = row * per_row;
+    return cost;
+}
+
+
+// Regroups a compressed outer x inner structure by inner index. Entries of
+// every output group come out sorted because the outer loop is in order.
+void transpose_compressed(size_t outer, size_t inner,
+                          const std::vector<size_t>& ptr, const std::vector<size_t>& idx,
+                          const std::vector<MatrixItem>& val,
+                          std::vector<size_t>& t_ptr, std::vector<size_t>& t_idx,
+                          std::vector<MatrixItem>& t_val)
+{
+    t_ptr.assign(inner + 1, 0);
+    t_idx.resize(idx.size());
+    t_val.resize(val.size());
+
+    for (size_t pos = 0; pos < idx.size(); pos++)
+        t_ptr[idx[pos] + 1]++;
+    for (size_t group = 0; group < inner; group++)
+        t_ptr[group + 1] += t_ptr[group];
+
+    std::vector<size_t> next(t_ptr.begin(), t_ptr.end() - 1);
+    for (size_t group = 0; group < outer; group++) {
+        for (size_t pos = ptr[group]; pos < ptr[group + 1]; pos++) {
+            size_t dst = next[idx[pos]]++;
+            t_idx[dst] = group;
+            t_val[dst] = val[pos];
+        }
+    }
+}
+
+
+MatrixItem* dense_items(Matrix& A)
+{
+    return (A.get_rows() == 0) ? nullptr : &A[0, 0];
+}
+
+
+const MatrixItem* dense_items(const Matrix& A)
+{
+    return MatrixView(A).get_data();
+}
+
+
+Matrix dense_zeros(size_t rows, size_t cols)
+{
+    Matrix C(rows, cols);
+    C.set_zero();
+    return C;
+}
+
+}
+
+
+SparseMatrix::SparseMatrix()
+    : rows{0}, cols{0}, row_ptr(1, 0) {}
+
+
+SparseMatrix::SparseMatrix(const size_t rows, const size_t cols)
+    : rows{rows}, cols{cols}, row_ptr(rows + 1, 0) {}
+
+
+SparseMatrix::SparseMatrix(const Matrix& A, const MatrixItem drop)
+    : SparseMatrix(A.get_rows(), A.get_cols())
+{
+    const MatrixItem* a = dense_items(A);
+
+    for (size_t row = 0; row < rows; row++) {
+        for (size_t col = 0; col < cols; col++) {
+            MatrixItem value = a[row * cols + col];
+            if (value > drop || value < -drop || (drop == 0.0 && value != 0.0)) {
+                col_idx.push_back(col);
+                values.push_back(value);
+            }
+        }
+        row_ptr[row + 1] = col_idx.size();
+    }
+}
+
+
+SparseMatrix::SparseMatrix(const size_t rows, const size_t cols, std::vector<Triplet> triplets)
+    : SparseMatrix(rows, cols)
+{
+    for (const Triplet& t : triplets)
+        if (t.row >= rows || t.col >= cols)
+            throw OUT_OF_RANGE;
+
+    std::sort(triplets.begin(), triplets.end(), [](const Triplet& a, const Triplet& b) {
+        return (a.row != b.row) ? a.row < b.row : a.col < b.col;
+    });
+
+    col_idx.reserve(triplets.size());
+    values.reserve(triplets.size());
+
+    for (size_t pos = 0; pos < triplets.size(); pos++) {
+        const Triplet& t = triplets[pos];
+        if (pos > 0 && triplets[pos - 1].row == t.row && triplets[pos - 1].col == t.col) {
+            values.back() += t.value;
+            continue;
+        }
+        col_idx.push_back(t.col);
+        values.push_back(t.value);
+        row_ptr[t.row + 1]++;
+    }
+
+    for (size_t row = 0; row < rows; row++)
+        row_ptr[row + 1] += row_ptr[row];
+}
+
+
+SparseMatrix::SparseMatrix(const SparseColumns& A)
+    : rows{A.rows}, cols{A.cols}
+{
+    if (A.col_ptr.size() != cols + 1 || A.row_idx.size() != A.values.size())
+        throw WRONG_CONDITIONS;
+    if (A.col_ptr[0] != 0 || A.col_ptr[cols] != A.values.size())
+        throw WRONG_CONDITIONS;
+    for (size_t col = 0; col < cols; col++)
+        if (A.col_ptr[col] > A.col_ptr[col + 1])
+            throw WRONG_CONDITIONS;
+    for (size_t row : A.row_idx)
+        if (row >= rows)
+            throw OUT_OF_RANGE;
+
+    transpose_compressed(cols, rows, A.col_ptr, A.row_idx, A.values, row_ptr, col_idx, values);
+}
+
+
+size_t SparseMatrix::get_rows() const
+{
+    return rows;
+}
+
+
+size_t SparseMatrix::get_cols() const
+{
+    return cols;
+}
+
+
+size_t SparseMatrix::nnz() const
+{
+    return values.size();
+}
+
+
+double SparseMatrix::density() const
+{
+    return (rows == 0 || cols == 0) ? 0.0 : (double)nnz() / ((double)rows * (double)cols);
+}
+
+
+const std::vector<size_t>& SparseMatrix::get_row_ptr() const
+{
+    return row_ptr;
+}
+
+
+const std::vector<size_t>& SparseMatrix::get_col_idx() const
+{
+    return col_idx;
+}
+
+
+const std::vector<MatrixItem>& SparseMatrix::get_values() const
+{
+    return values;
+}
+
+
+MatrixItem SparseMatrix::operator[](const size_t row, const size_t col) const
+{
+    if (row >= rows || col >= cols)
+        throw OUT_OF_RANGE;
+
+    auto first = col_idx.begin() + row_ptr[row];
+    auto last = col_idx.begin() + row_ptr[row + 1];
+    auto it = std::lower_bound(first, last, col);
+
+    return (it != last && *it == col) ? values[it - col_idx.begin()] : 0.0;
+}
+
+
+Matrix SparseMatrix::to_dense() const
+{
+    Matrix A = dense_zeros(rows, cols);
+    MatrixItem* a = dense_items(A);
+
+    for (size_t row = 0; row < rows; row++)
+        for (size_t pos = row_ptr[row]; pos < row_ptr[row + 1]; pos++)
+            a[row * cols + col_idx[pos]] = values[pos];
+
+    return A;
+}
+
+
+SparseColumns SparseMatrix::to_columns() const
+{
+    SparseColumns A;
+    A.rows = rows;
+    A.cols = cols;
+    transpose_compressed(rows, cols, row_ptr, col_idx, values, A.col_ptr, A.row_idx, A.values);
+    return A;
+}
+
+
+SparseMatrix SparseMatrix::T() const
+{
+    SparseMatrix trn;
+    trn.rows = cols;
+    trn.cols = rows;
+    transpose_compressed(rows, cols, row_ptr, col_idx, values, trn.row_ptr, trn.col_idx, trn.values);
+    return trn;
+}
+
+
+void spmv(MatrixItem alpha, const SparseMatrix& A, const MatrixItem* x, MatrixItem beta, MatrixItem* y)
+{
+    const std::vector<size_t>& ptr = A.get_row_ptr();
+    const size_t* idx = A.get_col_idx().data();
+    const MatrixItem* val = A.get_values().data();
+
+    parallel_rows(ptr, [&](size_t begin, size_t end) {
+        for (size_t row = begin; row < end; row++) {
+            MatrixItem sum = 0.0;
+            for (size_t pos = ptr[row]; pos < ptr[row + 1]; pos++)
+                sum += val[pos] * x[idx[pos]];
+
+            y[row] = (beta == 0.0) ? alpha * sum : alpha * sum + beta * y[row];
+        }
+    });
+}
+
+
+std::vector<MatrixItem> operator*(const SparseMatrix& A, const std::vector<MatrixItem>& x)
+{
+    if (x.size() != A.get_cols())
+        throw WRONG_CONDITIONS;
+
+    std::vector<MatrixItem> y(A.get_rows());
+    spmv(1.0, A, x.data(), 0.0, y.data());
+    return y;
+}
+
+
+SparseMatrix operator*(const SparseMatrix& A, const SparseMatrix& B)
+{
+    if (A.get_cols() != B.get_rows())
+        throw WRONG_CONDITIONS;
+
+    if (A.density() > SPARSE_DENSITY_THRESHOLD && B.density() > SPARSE_DENSITY_THRESHOLD)
+        return SparseMatrix(A.to_dense() * B.to_dense());
+
+    const size_t rows = A.get_rows();
+    const size_t cols = B.get_cols();
+    const std::vector<size_t>& a_ptr = A.get_row_ptr();
+    const std::vector<size_t>& a_idx = A.get_col_idx();
+    const std::vector<MatrixItem>& a_val = A.get_values();
+    const std::vector<size_t>& b_ptr = B.get_row_ptr();
+    const std::vector<size_t>& b_idx = B.get_col_idx();
+    const std::vector<MatrixItem>& b_val = B.get_values();
+
+    // Multiply-adds of every row, to balance the threads
+    std::vector<size_t> flops(rows + 1, 0);
+    for (size_t row = 0; row < rows; row++) {
+        size_t work = 0;
+        for (size_t pos = a_ptr[row]; pos < a_ptr[row + 1]; pos++)
+            work += b_ptr[a_idx[pos] + 1] - b_ptr[a_idx[pos]];
+        flops[row + 1] = flops[row] + work;
+    }
+
+    struct Chunk
+    {
+        size_t begin;
+        std::vector<size_t> idx;
+        std::vector<MatrixItem> val;
+    };
+
+    std::vector<size_t> row_nnz(rows + 1, 0);
+    std::vector<Chunk> chunks;
+    std::mutex chunks_lock;
+
+    parallel_rows(flops, [&](size_t begin, size_t end) {
+        Chunk chunk{begin, {}, {}};
+        std::vector<MatrixItem> acc(cols);
+        std::vector<size_t> mark(cols, SIZE_MAX);
+        std::vector<size_t> touched;
+
+        for (size_t row = begin; row < end; row++) {
+            touched.clear();
+
+            for (size_t pos = a_ptr[row]; pos < a_ptr[row + 1]; pos++) {
+                MatrixItem a = a_val[pos];
+                size_t mid = a_idx[pos];
+
+                for (size_t bpos = b_ptr[mid]; bpos < b_ptr[mid + 1]; bpos++) {
+                    size_t col = b_idx[bpos];
+                    if (mark[col] != row) {
+                        mark[col] = row;
+                        acc[col] = 0.0;
+                        touched.push_back(col);
+                    }
+                    acc[col] += a * b_val[bpos];
+                }
+            }
+
+            std::sort(touched.begin(), touched.end());
+            for (size_t col : touched) {
+                chunk.idx.push_back(col);
+                chunk.val.push_back(acc[col]);
+            }
+            row_nnz[row + 1] = touched.size();
+        }
+
+        std::lock_guard<std::mutex> guard(chunks_lock);
+        chunks.push_back(std::move(chunk));
+    });
+
+    std::sort(chunks.begin(), chunks.end(), [](const Chunk& a, const Chunk& b) { return a.begin < b.begin; });
+
+    SparseMatrix C(rows, cols);
+    C.row_ptr = std::move(row_nnz);
+    for (size_t row = 0; row < rows; row++)
+        C.row_ptr[row + 1] += C.row_ptr[row];
+
+    C.col_idx.reserve(C.row_ptr[rows]);
+    C.values.reserve(C.row_ptr[rows]);
+    for (const Chunk& chunk : chunks) {
+        C.col_idx.insert(C.col_idx.end(), chunk.idx.begin(), chunk.idx.end());
+        C.values.insert(C.values.end(), chunk.val.begin(), chunk.val.end());
+    }
+
+    return C;
+}
+
+
+Matrix operator*(const SparseMatrix& A, const Matrix& B)
+{
+    if (A.get_cols() != B.get_rows())
+        throw WRONG_CONDITIONS;
+
+    if (A.density() > SPARSE_DENSITY_THRESHOLD)
+        return A.to_dense() * B;
+
+    const size_t n = B.get_cols();
+    const std::vector<size_t>& ptr = A.get_row_ptr();
+    const size_t* idx = A.get_col_idx().data();
+    const MatrixItem* val = A.get_values().data();
+    const MatrixItem* b = dense_items(B);
+
+    Matrix C = dense_zeros(A.get_rows(), n);
+    MatrixItem* c = dense_items(C);
+
+    std::vector<size_t> cost(ptr.begin(), ptr.end());
+    for (size_t& work : cost)
+        work *= n;
+
+    parallel_rows(cost, [&](size_t begin, size_t end) {
+        for (size_t row = begin; row < end; row++) {
+            MatrixItem* c_row = c + row * n;
+            for (size_t pos = ptr[row]; pos < ptr[row + 1]; pos++) {
+                const MatrixItem* b_row = b + idx[pos] * n;
+                MatrixItem factor = val[pos];
+                for (size_t col = 0; col < n; col++)
+                    c_row[col] += factor * b_row[col];
+            }
+        }
+    });
+
+    return C;
+}
+
+
+Matrix operator*(const Matrix& A, const SparseMatrix& B)
+{
+    if (A.get_cols() != B.get_rows())
+        throw WRONG_CONDITIONS;
+
+    if (B.density() > SPARSE_DENSITY_THRESHOLD)
+        return A * B.to_dense();
+
+    const size_t k = A.get_cols();
+    const size_t n = B.get_cols();
+    const std::vector<size_t>& ptr = B.get_row_ptr();
+    const size_t* idx = B.get_col_idx().data();
+    const MatrixItem* val = B.get_values().data();
+    const MatrixItem* a = dense_items(A);
+
+    Matrix C = dense_zeros(A.get_rows(), n);
+    MatrixItem* c = dense_items(C);
+
+    parallel_rows(uniform_cost(A.get_rows(), B.nnz() + k), [&](size_t begin, size_t end) {
+        for (size_t row = begin; row < end; row++) {
+            MatrixItem* c_row = c + row * n;
+            for (size_t mid = 0; mid < k; mid++) {
+                MatrixItem factor = a[row * k + mid];
+                if (factor == 0.0)
+                    continue;
+                for (size_t pos = ptr[mid]; pos < ptr[mid + 1]; pos++)
+                    c_row[idx[pos]] += factor * val[pos];
+            }
+        }
+    });
+
+    return C;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include "matrix.hpp"
+
+// Above this fraction of nonzeros the products switch to the dense gemm kernels
+constexpr double SPARSE_DENSITY_THRESHOLD = 0.1;
+
+struct Triplet
+{
+    size_t row;
+    size_t col;
+    MatrixItem value;
+};
+
+// Compressed sparse columns: column col holds row_idx / values [col_ptr[col], col_ptr[col + 1]).
+struct SparseColumns
+{
+    size_t rows = 0;
+    size_t cols = 0;
+    std::vector<size_t> col_ptr;
+    std::vector<size_t> row_idx;
+    std::vector<MatrixItem> values;
+};
+
+// Compressed sparse rows: row row holds col_idx / values [row_ptr[row], row_ptr[row + 1]),
+// columns ascending and without duplicates.
+class SparseMatrix
+{
+private:
+    size_t rows;
+    size_t cols;
+    std::vector<size_t> row_ptr;
+    std::vector<size_t> col_idx;
+    std::vector<MatrixItem> values;
+
+public:
+    SparseMatrix();
+    // All zeros
+    SparseMatrix(const size_t rows, const size_t cols);
+    // Entries with |value| <= drop are left out
+    explicit SparseMatrix(const Matrix& A, const MatrixItem drop = 0.0);
+    // Duplicate (row, col) triplets are summed
+    SparseMatrix(const size_t rows, const size_t cols, std::vector<Triplet> triplets);
+    explicit SparseMatrix(const SparseColumns& A);
+
+    size_t get_rows() const;
+    size_t get_cols() const;
+    size_t nnz() const;
+    double density() const;
+
+    const std::vector<size_t>& get_row_ptr() const;
+    const std::vector<size_t>& get_col_idx() const;
+    const std::vector<MatrixItem>& get_values() const;
+
+    // Zero for entries that are not stored
+    MatrixItem operator[](const size_t row, const size_t col) const;
+
+    Matrix to_dense() const;
+    SparseColumns to_columns() const;
+
+    // Counting sort by column: O(nnz + rows + cols)
+    SparseMatrix T() const;
+
+    friend SparseMatrix operator*(const SparseMatrix& A, const SparseMatrix& B);
+};
+
+// y = alpha * A * x + beta * y for dense vectors of length cols and rows.
+// Rows are split between threads by their number of nonzeros.
+void spmv(MatrixItem alpha, const SparseMatrix& A, const MatrixItem* x, MatrixItem beta, MatrixItem* y);
+std::vector<MatrixItem> operator*(const SparseMatrix& A, const std::vector<MatrixItem>& x);
+
+// Gustavson's row-by-row product with a dense accumulator per thread.
+// Dense enough operands go through gemm and are compressed afterwards.
+SparseMatrix operator*(const SparseMatrix& A, const SparseMatrix& B);
+
+Matrix operator*(const SparseMatrix& A, const Matrix& B);
+Matrix operator*(const Matrix& A, const SparseMatrix& B);
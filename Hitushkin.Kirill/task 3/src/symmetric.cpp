@@ -0,0 +1,474 @@
+#include <math.h>
+#include <algorithm>
+#include "symmetric.hpp"
+#include "gemm.hpp"
+
+namespace {
+
+// Rows of A^T * A computed per gemm call
+constexpr size_t GRAM_BLOCK = 64;
+
+// Bunch-Kaufman growth bound, (1 + sqrt(17)) / 8
+const MatrixItem BK_ALPHA = (1.0 + sqrt(17.0)) / 8.0;
+
+}
+
+
+size_t SymmetricMatrix::index(size_t row, size_t col)
+{
+    if (row > col)
+        std::swap(row, col);
+
+    return row + col * (col + 1) / 2;
+}
+
+
+SymmetricMatrix::SymmetricMatrix()
+    : n{0} {}
+
+
+SymmetricMatrix::SymmetricMatrix(const size_t n)
+    : n{n}, items(n * (n + 1) / 2, 0.0) {}
+
+
+SymmetricMatrix::SymmetricMatrix(const Matrix& A)
+    : SymmetricMatrix(A.get_rows())
+{
+    if (A.get_rows() != A.get_cols())
+        throw WRONG_CONDITIONS;
+
+    for (size_t col = 0; col < n; col++)
+        for (size_t row = 0; row <= col; row++)
+            items[index(row, col)] = A[row, col];
+}
+
+
+size_t SymmetricMatrix::get_size() const
+{
+    return n;
+}
+
+
+MatrixItem& SymmetricMatrix::operator[](const size_t row, const size_t col)
+{
+    if (row >= n || col >= n)
+        throw OUT_OF_RANGE;
+
+    invalidate();
+    return items[index(row, col)];
+}
+
+
+const MatrixItem& SymmetricMatrix::operator[](const size_t row, const size_t col) const
+{
+    if (row >= n || col >= n)
+        throw OUT_OF_RANGE;
+
+    return items[index(row, col)];
+}
+
+
+Matrix SymmetricMatrix::to_dense() const
+{
+    Matrix A(n, n);
+
+    for (size_t col = 0; col < n; col++) {
+        for (size_t row = 0; row <= col; row++) {
+            A[row, col] = items[index(row, col)];
+            A[col, row] = items[index(row, col)];
+        }
+    }
+
+    return A;
+}
+
+
+void SymmetricMatrix::invalidate()
+{
+    cholesky.reset();
+    ldlt.reset();
+}
+
+
+void SymmetricMatrix::factorize() const
+{
+    if (!cholesky)
+        cholesky = std::make_shared<const Cholesky>(*this);
+
+    if (!cholesky->is_positive_definite() && !ldlt)
+        ldlt = std::make_shared<const BunchKaufman>(*this);
+}
+
+
+double SymmetricMatrix::det() const
+{
+    factorize();
+
+    if (cholesky->is_positive_definite())
+        return cholesky->det();
+
+    return ldlt->det();
+}
+
+
+Matrix SymmetricMatrix::solve(const Matrix& B) const
+{
+    factorize();
+
+    if (cholesky->is_positive_definite())
+        return cholesky->solve(B);
+
+    return ldlt->solve(B);
+}
+
+
+SymmetricMatrix gram(const MatrixView& A)
+{
+    const size_t m = A.get_rows();
+    const size_t n = A.get_cols();
+    const MatrixItem* a = A.get_data();
+    const size_t rs = A.get_row_stride();
+    const size_t cs = A.get_col_stride();
+
+    SymmetricMatrix G(n);
+    std::vector<MatrixItem> panel(GRAM_BLOCK * n);
+
+    for (size_t row0 = 0; row0 < n; row0 += GRAM_BLOCK) {
+        size_t height = std::min(GRAM_BLOCK, n - row0);
+        size_t width = n - row0;
+
+        // panel = A[:, row0 : row0 + height]^T * A[:, row0 : n], the block row
+        // of G from its diagonal block rightwards; nothing left of it is computed
+        gemm_kernel(height, width, m,
+                    1.0,
+                    a + row0 * cs, cs, rs,
+                    a + row0 * cs, rs, cs,
+                    0.0,
+                    panel.data(), width, 1);
+
+        for (size_t col = row0; col < n; col++) {
+            MatrixItem* g_col = G.items.data() + col * (col + 1) / 2;
+            size_t last = std::min(col + 1, row0 + height);
+            for (size_t row = row0; row < last; row++)
+                g_col[row] = panel[(row - row0) * width + (col - row0)];
+        }
+    }
+
+    return G;
+}
+
+
+// Column by column, U[i, j] = (A[i, j] - U[0:i, i] . U[0:i, j]) / U[i, i].
+// Both operands of every dot product are contiguous packed columns.
+Cholesky::Cholesky(const SymmetricMatrix& A)
+    : factor{A}, positive{true}
+{
+    factor.invalidate();
+    const size_t n = factor.n;
+    MatrixItem* u = factor.items.data();
+
+    for (size_t col = 0; col < n && positive; col++) {
+        MatrixItem* u_col = u + col * (col + 1) / 2;
+
+        for (size_t row = 0; row < col; row++) {
+            const MatrixItem* u_row = u + row * (row + 1) / 2;
+            MatrixItem sum = u_col[row];
+            for (size_t idx = 0; idx < row; idx++)
+                sum -= u_row[idx] * u_col[idx];
+            u_col[row] = sum / u_row[row];
+        }
+
+        MatrixItem diag = u_col[col];
+        for (size_t idx = 0; idx < col; idx++)
+            diag -= u_col[idx] * u_col[idx];
+
+        if (!(diag > 0.0)) {
+            positive = false;
+            break;
+        }
+
+        u_col[col] = sqrt(diag);
+    }
+}
+
+
+bool Cholesky::is_positive_definite() const
+{
+    return positive;
+}
+
+
+double Cholesky::det() const
+{
+    if (!positive)
+        throw WRONG_CONDITIONS;
+
+    double det = 1.0;
+    for (size_t col = 0; col < factor.n; col++) {
+        MatrixItem diag = factor.items[SymmetricMatrix::index(col, col)];
+        det *= diag * diag;
+    }
+
+    return det;
+}
+
+
+double Cholesky::logdet() const
+{
+    if (!positive)
+        throw WRONG_CONDITIONS;
+
+    double sum = 0.0;
+    for (size_t col = 0; col < factor.n; col++)
+        sum += 2.0 * log(factor.items[SymmetricMatrix::index(col, col)]);
+
+    return sum;
+}
+
+
+Matrix Cholesky::solve(const Matrix& B) const
+{
+    const size_t n = factor.n;
+
+    if (!positive || B.get_rows() != n)
+        throw WRONG_CONDITIONS;
+
+    const size_t k = B.get_cols();
+    const MatrixItem* u = factor.items.data();
+    Matrix X(B);
+    MatrixItem* x = &X[0, 0];
+
+    // U^T y = b: row col of U^T is the packed column col of U
+    for (size_t col = 0; col < n; col++) {
+        const MatrixItem* u_col = u + col * (col + 1) / 2;
+        MatrixItem* x_row = x + col * k;
+        for (size_t idx = 0; idx < col; idx++) {
+            const MatrixItem* y_row = x + idx * k;
+            for (size_t rhs = 0; rhs < k; rhs++)
+                x_row[rhs] -= u_col[idx] * y_row[rhs];
+        }
+        for (size_t rhs = 0; rhs < k; rhs++)
+            x_row[rhs] /= u_col[col];
+    }
+
+    // U x = y, pushing every solved row up its column
+    for (size_t col = n; col-- > 0;) {
+        const MatrixItem* u_col = u + col * (col + 1) / 2;
+        MatrixItem* x_row = x + col * k;
+        for (size_t rhs = 0; rhs < k; rhs++)
+            x_row[rhs] /= u_col[col];
+        for (size_t idx = 0; idx < col; idx++) {
+            MatrixItem* y_row = x + idx * k;
+            for (size_t rhs = 0; rhs < k; rhs++)
+                y_row[rhs] -= u_col[idx] * x_row[rhs];
+        }
+    }
+
+    return X;
+}
+
+
+// Works on the lower triangle, where (row, col) with row >= col lives at
+// row_ptr(row)[col]: the packed column row of the upper storage.
+BunchKaufman::BunchKaufman(const SymmetricMatrix& A)
+    : factor{A}, perm(A.n), pair_start(A.n, false), singular{false}
+{
+    factor.invalidate();
+    const size_t n = factor.n;
+    MatrixItem* u = factor.items.data();
+    auto row_ptr = [u](size_t row) { return u + row * (row + 1) / 2; };
+    auto at = [u](size_t row, size_t col) -> MatrixItem& { return u[SymmetricMatrix::index(row, col)]; };
+
+    for (size_t idx = 0; idx < n; idx++)
+        perm[idx] = idx;
+
+    std::vector<MatrixItem> l0(n), l1(n);
+
+    for (size_t k = 0; k < n;) {
+        const MatrixItem absakk = fabs(row_ptr(k)[k]);
+        size_t imax = k;
+        MatrixItem colmax = 0.0;
+        for (size_t row = k + 1; row < n; row++) {
+            if (fabs(row_ptr(row)[k]) > colmax) {
+                colmax = fabs(row_ptr(row)[k]);
+                imax = row;
+            }
+        }
+
+        if (std::max(absakk, colmax) == 0.0) {
+            // Column k is already eliminated, D gets a zero
+            singular = true;
+            k++;
+            continue;
+        }
+
+        size_t kp = k, step = 1;
+        if (absakk < BK_ALPHA * colmax) {
+            MatrixItem rowmax = 0.0;
+            for (size_t col = k; col < n; col++)
+                if (col != imax)
+                    rowmax = std::max(rowmax, fabs(at(imax, col)));
+
+            if (absakk >= BK_ALPHA * colmax * (colmax / rowmax)) {
+                kp = k;
+            } else if (fabs(row_ptr(imax)[imax]) >= BK_ALPHA * rowmax) {
+                kp = imax;
+            } else {
+                kp = imax;
+                step = 2;
+            }
+        }
+
+        // Symmetric interchange of kk and kp, including the rows of L so far
+        const size_t kk = k + step - 1;
+        if (kp != kk) {
+            for (size_t col = 0; col < k; col++)
+                std::swap(row_ptr(kk)[col], row_ptr(kp)[col]);
+            for (size_t idx = k; idx < n; idx++)
+                if (idx != kk && idx != kp)
+                    std::swap(at(idx, kk), at(idx, kp));
+            std::swap(row_ptr(kk)[kk], row_ptr(kp)[kp]);
+            std::swap(perm[kk], perm[kp]);
+        }
+
+        if (step == 1) {
+            const MatrixItem d = row_ptr(k)[k];
+            for (size_t row = k + 1; row < n; row++)
+                l0[row] = row_ptr(row)[k] / d;
+
+            // A[k+1:, k+1:] -= l * d * l^T, one contiguous row at a time
+            for (size_t row = k + 1; row < n; row++) {
+                MatrixItem* a_row = row_ptr(row);
+                const MatrixItem w = a_row[k];
+                for (size_t col = k + 1; col <= row; col++)
+                    a_row[col] -= l0[col] * w;
+                a_row[k] = l0[row];
+            }
+        } else {
+            pair_start[k] = true;
+            const MatrixItem d11 = row_ptr(k)[k];
+            const MatrixItem d21 = row_ptr(k + 1)[k];
+            const MatrixItem d22 = row_ptr(k + 1)[k + 1];
+            const MatrixItem d_det = d11 * d22 - d21 * d21;
+
+            for (size_t row = k + 2; row < n; row++) {
+                const MatrixItem w0 = row_ptr(row)[k];
+                const MatrixItem w1 = row_ptr(row)[k + 1];
+                l0[row] = (w0 * d22 - w1 * d21) / d_det;
+                l1[row] = (w1 * d11 - w0 * d21) / d_det;
+            }
+
+            // A[k+2:, k+2:] -= W * D^-1 * W^T with W = A[k+2:, k:k+2]
+            for (size_t row = k + 2; row < n; row++) {
+                MatrixItem* a_row = row_ptr(row);
+                const MatrixItem w0 = a_row[k];
+                const MatrixItem w1 = a_row[k + 1];
+                for (size_t col = k + 2; col <= row; col++)
+                    a_row[col] -= l0[col] * w0 + l1[col] * w1;
+                a_row[k] = l0[row];
+                a_row[k + 1] = l1[row];
+            }
+        }
+
+        k += step;
+    }
+}
+
+
+bool BunchKaufman::is_singular() const
+{
+    return singular;
+}
+
+
+// P A P^T has the same determinant as A, so only D counts
+double BunchKaufman::det() const
+{
+    if (singular)
+        return 0.0;
+
+    const MatrixItem* u = factor.items.data();
+    double det = 1.0;
+    for (size_t k = 0; k < factor.n; k++) {
+        const MatrixItem* row_k = u + k * (k + 1) / 2;
+        if (pair_start[k]) {
+            const MatrixItem* row_k1 = row_k + k + 1;
+            det *= row_k[k] * row_k1[k + 1] - row_k1[k] * row_k1[k];
+            k++;
+        } else {
+            det *= row_k[k];
+        }
+    }
+
+    return det;
+}
+
+
+Matrix BunchKaufman::solve(const Matrix& B) const
+{
+    const size_t n = factor.n;
+
+    if (singular || B.get_rows() != n)
+        throw WRONG_CONDITIONS;
+
+    const size_t k = B.get_cols();
+    const MatrixItem* u = factor.items.data();
+    Matrix Y(n, k);
+    MatrixItem* y = &Y[0, 0];
+
+    for (size_t row = 0; row < n; row++)
+        for (size_t rhs = 0; rhs < k; rhs++)
+            y[row * k + rhs] = B[perm[row], rhs];
+
+    // L z = P b, row by row; entries of L inside a 2x2 block of D are zero
+    for (size_t row = 0; row < n; row++) {
+        const MatrixItem* l_row = u + row * (row + 1) / 2;
+        MatrixItem* y_row = y + row * k;
+        const size_t last = (row > 0 && pair_start[row - 1]) ? row - 1 : row;
+        for (size_t idx = 0; idx < last; idx++) {
+            const MatrixItem* z_row = y + idx * k;
+            for (size_t rhs = 0; rhs < k; rhs++)
+                y_row[rhs] -= l_row[idx] * z_row[rhs];
+        }
+    }
+
+    // D w = z, block by block
+    for (size_t row = 0; row < n; row++) {
+        const MatrixItem* d_row = u + row * (row + 1) / 2;
+        MatrixItem* y_row = y + row * k;
+        if (pair_start[row]) {
+            const MatrixItem* d_next = d_row + row + 1;
+            const MatrixItem d11 = d_row[row], d21 = d_next[row], d22 = d_next[row + 1];
+            const MatrixItem d_det = d11 * d22 - d21 * d21;
+            MatrixItem* y_next = y_row + k;
+            for (size_t rhs = 0; rhs < k; rhs++) {
+                const MatrixItem z0 = y_row[rhs], z1 = y_next[rhs];
+                y_row[rhs] = (z0 * d22 - z1 * d21) / d_det;
+                y_next[rhs] = (z1 * d11 - z0 * d21) / d_det;
+            }
+            row++;
+        } else {
+            for (size_t rhs = 0; rhs < k; rhs++)
+                y_row[rhs] /= d_row[row];
+        }
+    }
+
+    // L^T v = w, pushing every solved row back through its row of L
+    for (size_t row = n; row-- > 0;) {
+        const MatrixItem* l_row = u + row * (row + 1) / 2;
+        const MatrixItem* v_row = y + row * k;
+        const size_t last = (row > 0 && pair_start[row - 1]) ? row - 1 : row;
+        for (size_t idx = 0; idx < last; idx++) {
+            MatrixItem* w_row = y + idx * k;
+            for (size_t rhs = 0; rhs < k; rhs++)
+                w_row[rhs] -= l_row[idx] * v_row[rhs];
+        }
+    }
+
+    Matrix X(n, k);
+    for (size_t row = 0; row < n; row++)
+        for (size_t rhs = 0; rhs < k; rhs++)
+            X[perm[row], rhs] = y[row * k + rhs];
+
+    return X;
+}
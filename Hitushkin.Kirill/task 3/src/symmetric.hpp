@@ -0,0 +1,96 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "matrix.hpp"
+
+class Cholesky;
+class BunchKaufman;
+
+// Symmetric n x n matrix with only the upper triangle stored, packed by
+// columns as LAPACK's 'U' format: (row, col) with row <= col lives at
+// items[row + col * (col + 1) / 2], and (col, row) reads the same item.
+class SymmetricMatrix
+{
+private:
+    size_t n;
+    std::vector<MatrixItem> items;
+
+    // Factorizations behind det() and solve(), built on first use and dropped
+    // by the non-const operator[]. Concurrent first calls must be serialized.
+    mutable std::shared_ptr<const Cholesky> cholesky;
+    mutable std::shared_ptr<const BunchKaufman> ldlt;
+
+    static size_t index(size_t row, size_t col);
+    void factorize() const;
+    void invalidate();
+
+public:
+    SymmetricMatrix();
+    // All zeros
+    explicit SymmetricMatrix(const size_t n);
+    // Upper triangle of a square A; the lower one is not looked at
+    explicit SymmetricMatrix(const Matrix& A);
+
+    size_t get_size() const;
+
+    MatrixItem& operator[](const size_t row, const size_t col);
+    const MatrixItem& operator[](const size_t row, const size_t col) const;
+
+    Matrix to_dense() const;
+
+    // Cholesky, or Bunch-Kaufman LDL^T in the packed storage when A is not
+    // positive definite; either is factored once until the next write
+    double det() const;
+    Matrix solve(const Matrix& B) const;
+
+    friend class Cholesky;
+    friend class BunchKaufman;
+    friend SymmetricMatrix gram(const MatrixView& A);
+};
+
+// A^T * A for an m x n A, like BLAS syrk: only the upper triangle is computed,
+// one block row at a time through the packed gemm kernel. The transpose is
+// never formed, a transposed view just walks A the other way.
+SymmetricMatrix gram(const MatrixView& A);
+
+// A = U^T * U for a symmetric positive definite A, U upper triangular and
+// packed the same way as SymmetricMatrix. Factored once and reused, like LU.
+class Cholesky
+{
+private:
+    SymmetricMatrix factor;
+    bool positive;
+
+public:
+    explicit Cholesky(const SymmetricMatrix& A);
+
+    // False when a pivot was not positive: A is not SPD and nothing else is valid
+    bool is_positive_definite() const;
+
+    double det() const;
+    double logdet() const;
+    Matrix solve(const Matrix& B) const;
+};
+
+// P A P^T = L D L^T for any symmetric A, with L unit lower triangular and D
+// block diagonal with 1x1 and 2x2 blocks, by Bunch-Kaufman pivoting
+// (alpha = (1 + sqrt(17)) / 8). Row row of L lies in the packed column row,
+// so the updates walk contiguous items.
+class BunchKaufman
+{
+private:
+    SymmetricMatrix factor;
+    std::vector<size_t> perm;       // row perm[idx] of A is row idx of P A P^T
+    std::vector<bool> pair_start;   // D has a 2x2 block at (idx, idx + 1)
+    bool singular;
+
+public:
+    explicit BunchKaufman(const SymmetricMatrix& A);
+
+    bool is_singular() const;
+
+    double det() const;
+    // Throws WRONG_CONDITIONS for a singular A
+    Matrix solve(const Matrix& B) const;
+};
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "transpose.hpp"
+
+namespace {
+
+// Blocks at or below this size are transposed tile by tile.
+constexpr size_t LEAF = 32;
+
+// b[j][i] = a[i][j] for a 4x4 tile
+inline void tile_4x4(const MatrixItem* a, size_t lda, MatrixItem* b, size_t ldb)
+{
+#if defined(__AVX__)
+    __m256d r0 = _mm256_loadu_pd(a);
+    __m256d r1 = _mm256_loadu_pd(a + lda);
+    __m256d r2 = _mm256_loadu_pd(a + 2 * lda);
+    __m256d r3 = _mm256_loadu_pd(a + 3 * lda);
+    __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+    __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+    __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+    __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+    _mm256_storeu_pd(b, _mm256_permute2f128_pd(t0, t2, 0x20));
+    _mm256_storeu_pd(b + ldb, _mm256_permute2f128_pd(t1, t3, 0x20));
+    _mm256_storeu_pd(b + 2 * ldb, _mm256_permute2f128_pd(t0, t2, 0x31));
+    _mm256_storeu_pd(b + 3 * ldb, _mm256_permute2f128_pd(t1, t3, 0x31));
+#elif defined(__SSE2__)
+    for (size_t i = 0; i < 4; i += 2) {
+        for (size_t j = 0; j < 4; j += 2) {
+            __m128d upper = _mm_loadu_pd(a + i * lda + j);
+            __m128d lower = _mm_loadu_pd(a + (i + 1) * lda + j);
+            _mm_storeu_pd(b + j * ldb + i, _mm_unpacklo_pd(upper, lower));
+            _mm_storeu_pd(b + (j + 1) * ldb + i, _mm_unpackhi_pd(upper, lower));
+        }
+    }
+#else
+    for (size_t i = 0; i < 4; i++)
+        for (size_t j = 0; j < 4; j++)
+            b[j * ldb + i] = a[i * lda + j];
+#endif
+}
+
+
+void leaf(size_t rows, size_t cols, const MatrixItem* a, size_t lda, MatrixItem* b, size_t ldb)
+{
+    const size_t full_rows = rows & ~size_t(3);
+    const size_t full_cols = cols & ~size_t(3);
+
+    for (size_t i = 0; i < full_rows; i += 4)
+        for (size_t j = 0; j < full_cols; j += 4)
+            tile_4x4(a + i * lda + j, lda, b + j * ldb + i, ldb);
+
+    for (size_t i = 0; i < rows; i++)
+        for (size_t j = (i < full_rows) ? full_cols : 0; j < cols; j++)
+            b[j * ldb + i] = a[i * lda + j];
+}
+
+} // namespace
+
+
+void transpose_kernel(size_t rows, size_t cols, const MatrixItem* a, size_t lda, MatrixItem* b, size_t ldb)
+{
+    if (rows <= LEAF && cols <= LEAF) {
+        leaf(rows, cols, a, lda, b, ldb);
+        return;
+    }
+
+    // Split on a multiple of 4 so the halves keep whole register tiles
+    if (rows >= cols) {
+        const size_t half = (rows / 2 + 3) & ~size_t(3);
+        transpose_kernel(half, cols, a, lda, b, ldb);
+        transpose_kernel(rows - half, cols, a + half * lda, lda, b + half, ldb);
+    } else {
+        const size_t half = (cols / 2 + 3) & ~size_t(3);
+        transpose_kernel(rows, half, a, lda, b, ldb);
+        transpose_kernel(rows, cols - half, a + half, lda, b + half * ldb, ldb);
+    }
+}
+
+
+void transpose_square(size_t n, MatrixItem* a)
+{
+    const size_t full = n & ~size_t(3);
+    MatrixItem upper[16];
+    MatrixItem lower[16];
+
+    // Tile (i, j) and its mirror (j, i) go through two 4x4 buffers
+    for (size_t bi = 0; bi < full; bi += LEAF) {
+        for (size_t bj = bi; bj < full; bj += LEAF) {
+            for (size_t i = bi; i < std::min(bi + LEAF, full); i += 4) {
+                for (size_t j = (bi == bj) ? i : bj; j < std::min(bj + LEAF, full); j += 4) {
+                    MatrixItem* tile = a + i * n + j;
+                    MatrixItem* mirror = a + j * n + i;
+
+                    tile_4x4(tile, n, upper, 4);
+                    if (tile != mirror)
+                        tile_4x4(mirror, n, lower, 4);
+
+                    for (size_t row = 0; row < 4; row++) {
+                        memcpy(mirror + row * n, upper + row * 4, 4 * sizeof(MatrixItem));
+                        if (tile != mirror)
+                            memcpy(tile + row * n, lower + row * 4, 4 * sizeof(MatrixItem));
+                    }
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = (i < full) ? full : i + 1; j < n; j++)
+            std::swap(a[i * n + j], a[j * n + i]);
+}
+
+
+void transpose_cycles(size_t rows, size_t cols, MatrixItem* a)
+{
+    const size_t size = rows * cols;
+    if (size < 3)
+        return;
+
+    // Item k of the row-major matrix moves to k * rows mod (size - 1)
+    const size_t last = size - 1;
+    std::vector<bool> visited(size, false);
+
+    for (size_t start = 1; start < last; start++) {
+        if (visited[start])
+            continue;
+
+        size_t idx = start;
+        MatrixItem carried = a[start];
+
+        do {
+            const size_t next = idx * rows % last;
+            std::swap(a[next], carried);
+            visited[idx] = true;
+            idx = next;
+        } while (idx != start);
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include "matrix.hpp"
+
+// b = a^T for a rows x cols block; lda and ldb are the row strides of a and b.
+// Cache-oblivious: the longer side is halved until a block fits in L1,
+// leaves are done in 4x4 register tiles.
+void transpose_kernel(size_t rows, size_t cols, const MatrixItem* a, size_t lda, MatrixItem* b, size_t ldb);
+
+// In-place transpose of a dense row-major n x n matrix.
+void transpose_square(size_t n, MatrixItem* a);
+
+// In-place transpose of a dense row-major rows x cols matrix by following the
+// permutation cycles. Needs rows * cols / 8 bytes of bookkeeping, not a second matrix.
+void transpose_cycles(size_t rows, size_t cols, MatrixItem* a);
@@ -13,6 +13,14 @@ typedef struct {
 } Matrix; //  struct Matrix
 
 
+typedef struct {
+    size_t rows;
+    size_t cols;
+    const matrix_element ** row_ptrs;  //  rows of the viewed matrix, nothing is copied
+    size_t * col_idx;  //  columns of the viewed matrix, in order
+} MatrixView;  //  block or minor of a Matrix; must not outlive it
+
+
 
 
 
@@ -51,8 +59,19 @@ void matrix_error_handler(const enum MatrixErrors error, const char * func_name)
 Matrix matrix_sum(const Matrix * matrix_1, const Matrix * matrix_2);  //  done
 Matrix matrix_sub(const Matrix * matrix_1, const Matrix * matrix_2);  //  done
 void matrix_transposition(Matrix  *this);  // done
+Matrix matrix_transposed(const Matrix * this);
 double matrix_determinant(const Matrix * this);  //  done 
+double matrix_determinant_laplace(const Matrix * this);
 Matrix get_submatrix(const Matrix * this, const size_t row_to_delete, const size_t col_to_delete);  //  done
+MatrixView matrix_view(const Matrix * this);
+MatrixView matrix_block_view(const Matrix * this, const size_t first_row, const size_t rows,
+                             const size_t first_col, const size_t cols);
+MatrixView matrix_minor_view(const MatrixView * this, const size_t row_to_skip, const size_t col_to_skip);
+void delete_matrix_view(MatrixView * this);
+Matrix matrix_materialize(const MatrixView * this);
+double matrix_view_determinant(const MatrixView * this);
+double matrix_view_determinant_laplace(const MatrixView * this);
+Matrix matrix_view_multiplication(const MatrixView * view_1, const MatrixView * view_2);
 Matrix matrix_multiplication(const Matrix * matrix_1, const Matrix * matrix_2);  //  done
 Matrix matrix_power(const Matrix * this, const uint16_t power);
 void constant_division(Matrix this, double constant);
@@ -63,6 +82,9 @@ uint64_t factorial(const uint16_t number);
 static inline size_t matrix_size(const Matrix * this) {
     return this->cols * this->rows;
 }
+static inline matrix_element view_element(const MatrixView * this, const size_t row, const size_t col) {
+    return this->row_ptrs[row][this->col_idx[col]];
+}
 
 
 
@@ -2,12 +2,16 @@
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 #include "MatrixHandler.h"
 
 
 // #define DEBUG
 
 const Matrix NULL_MATRIX = {.rows = 0, .cols = 0, .data = NULL};
+const MatrixView NULL_VIEW = {.rows = 0, .cols = 0, .row_ptrs = NULL, .col_idx = NULL};
 
 Matrix create_matrix(const size_t rows, const size_t cols)
 {
@@ -89,7 +93,7 @@ void unit_pattern(Matrix * this, size_t size, matrix_element * fill_data) {
 
 
 void blank_pattern(Matrix * this, size_t size, matrix_element * fill_data) {
-    memset(fill_data, 0, size);
+    memset(fill_data, 0, size * sizeof(matrix_element));
 }
 
 
@@ -190,26 +194,300 @@ Matrix  matrix_sub(const Matrix * matrix_1, const Matrix * matrix_2) {
 }
 
 
+//  Tiles at or below this size are transposed directly, larger blocks are halved
+#define TRANSPOSE_LEAF 32
+
+
+//  4x4 micro-tile: dst[j][i] = src[i][j], strides in elements
+static void transpose_tile_4x4(const matrix_element * src, const size_t src_stride,
+                               matrix_element * dst, const size_t dst_stride) {
+#if defined(__AVX__)
+    __m256d r0 = _mm256_loadu_pd(src);
+    __m256d r1 = _mm256_loadu_pd(src + src_stride);
+    __m256d r2 = _mm256_loadu_pd(src + 2 * src_stride);
+    __m256d r3 = _mm256_loadu_pd(src + 3 * src_stride);
+    __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+    __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+    __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+    __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+    _mm256_storeu_pd(dst, _mm256_permute2f128_pd(t0, t2, 0x20));
+    _mm256_storeu_pd(dst + dst_stride, _mm256_permute2f128_pd(t1, t3, 0x20));
+    _mm256_storeu_pd(dst + 2 * dst_stride, _mm256_permute2f128_pd(t0, t2, 0x31));
+    _mm256_storeu_pd(dst + 3 * dst_stride, _mm256_permute2f128_pd(t1, t3, 0x31));
+#elif defined(__SSE2__)
+    for (size_t row = 0; row < 4; row += 2) {
+        for (size_t col = 0; col < 4; col += 2) {
+            __m128d upper = _mm_loadu_pd(src + row * src_stride + col);
+            __m128d lower = _mm_loadu_pd(src + (row + 1) * src_stride + col);
+            _mm_storeu_pd(dst + col * dst_stride + row, _mm_unpacklo_pd(upper, lower));
+            _mm_storeu_pd(dst + (col + 1) * dst_stride + row, _mm_unpackhi_pd(upper, lower));
+        }
+    }
+#else
+    for (size_t row = 0; row < 4; row++)
+        for (size_t col = 0; col < 4; col++)
+            dst[col * dst_stride + row] = src[row * src_stride + col];
+#endif
+}
+
+
+static void transpose_leaf(const matrix_element * src, const size_t src_stride,
+                           matrix_element * dst, const size_t dst_stride,
+                           const size_t rows, const size_t cols) {
+    size_t full_rows = rows & ~(size_t)3;
+    size_t full_cols = cols & ~(size_t)3;
+    for (size_t row = 0; row < full_rows; row += 4)
+        for (size_t col = 0; col < full_cols; col += 4)
+            transpose_tile_4x4(src + row * src_stride + col, src_stride, dst + col * dst_stride + row, dst_stride);
+    for (size_t row = 0; row < rows; row++) {
+        size_t first_col = row < full_rows ? full_cols : 0;
+        for (size_t col = first_col; col < cols; col++)
+            dst[col * dst_stride + row] = src[row * src_stride + col];
+    }
+}
+
+
+//  Cache-oblivious: halve the longer side until the block fits a leaf,
+//  so every level of the memory hierarchy sees square-ish blocks
+static void transpose_recursive(const matrix_element * src, const size_t src_stride,
+                                matrix_element * dst, const size_t dst_stride,
+                                const size_t rows, const size_t cols) {
+    if (rows <= TRANSPOSE_LEAF && cols <= TRANSPOSE_LEAF) {
+        transpose_leaf(src, src_stride, dst, dst_stride, rows, cols);
+        return;
+    }
+    if (rows >= cols) {
+        size_t half = (rows / 2 + 3) & ~(size_t)3;
+        transpose_recursive(src, src_stride, dst, dst_stride, half, cols);
+        transpose_recursive(src + half * src_stride, src_stride, dst + half, dst_stride, rows - half, cols);
+    } else {
+        size_t half = (cols / 2 + 3) & ~(size_t)3;
+        transpose_recursive(src, src_stride, dst, dst_stride, rows, half);
+        transpose_recursive(src + half, src_stride, dst + half * dst_stride, dst_stride, rows, cols - half);
+    }
+}
+
+
+//  Square n x n: the tile pairs (i, j) and (j, i) are swapped through a 4x4 buffer
+static void transpose_square_in_place(matrix_element * data, const size_t n) {
+    size_t full = n & ~(size_t)3;
+    matrix_element upper[16], lower[16];
+    for (size_t block_row = 0; block_row < full; block_row += TRANSPOSE_LEAF) {
+        size_t row_end = block_row + TRANSPOSE_LEAF < full ? block_row + TRANSPOSE_LEAF : full;
+        for (size_t block_col = block_row; block_col < full; block_col += TRANSPOSE_LEAF) {
+            size_t col_end = block_col + TRANSPOSE_LEAF < full ? block_col + TRANSPOSE_LEAF : full;
+            for (size_t row = block_row; row < row_end; row += 4) {
+                for (size_t col = (block_col == block_row ? row : block_col); col < col_end; col += 4) {
+                    matrix_element * tile = data + row * n + col;
+                    matrix_element * mirror = data + col * n + row;
+                    transpose_tile_4x4(tile, n, upper, 4);
+                    if (tile == mirror) {
+                        for (size_t idx = 0; idx < 4; idx++)
+                            memcpy(tile + idx * n, upper + idx * 4, 4 * sizeof(matrix_element));
+                        continue;
+                    }
+                    transpose_tile_4x4(mirror, n, lower, 4);
+                    for (size_t idx = 0; idx < 4; idx++) {
+                        memcpy(mirror + idx * n, upper + idx * 4, 4 * sizeof(matrix_element));
+                        memcpy(tile + idx * n, lower + idx * 4, 4 * sizeof(matrix_element));
+                    }
+                }
+            }
+        }
+    }
+    for (size_t row = 0; row < n; row++) {
+        for (size_t col = (row < full ? full : row + 1); col < n; col++) {
+            matrix_element buff = data[row * n + col];
+            data[row * n + col] = data[col * n + row];
+            data[col * n + row] = buff;
+        }
+    }
+}
+
+
+//  Rectangular rows x cols, element k moves to k * rows mod (size - 1).
+//  Each cycle is followed once; visited is a zeroed bitmap of size / 8 + 1
+//  bytes, far less than a second copy of the matrix.
+static void transpose_cycles_in_place(matrix_element * data, const size_t rows, const size_t cols,
+                                      unsigned char * visited) {
+    size_t size = rows * cols;
+    if (size < 3) return;
+    size_t last = size - 1;
+    for (size_t start = 1; start < last; start++) {
+        if (visited[start / 8] & (1u << (start % 8))) continue;
+        size_t idx = start;
+        matrix_element carried = data[start];
+        do {
+            size_t next = idx * rows % last;
+            matrix_element buff = data[next];
+            data[next] = carried;
+            carried = buff;
+            visited[idx / 8] |= (unsigned char)(1u << (idx % 8));
+            idx = next;
+        } while (idx != start);
+    }
+}
+
+
+//  Row pointers sit in front of the elements in the same allocation, so a new
+//  row count moves the elements by the difference in pointer count.
+//  Growing happens before the elements change, so a failed realloc leaves
+//  the matrix untouched.
+static bool matrix_grow_row_pointers(Matrix * this, const size_t new_rows) {
+    size_t size = matrix_size(this);
+    if (new_rows <= this->rows) return true;
+    matrix_element ** block = (matrix_element **)realloc(this->data,
+        new_rows * sizeof(matrix_element *) + size * sizeof(matrix_element));
+    if (NULL == block) return false;
+    memmove(block + new_rows, block + this->rows, size * sizeof(matrix_element));
+    this->data = block;
+    this->data[0] = (matrix_element *)(block + new_rows);
+    return true;
+}
+
+
+static void matrix_set_row_pointers(Matrix * this, const size_t new_rows, const size_t new_cols) {
+    size_t size = matrix_size(this);
+    matrix_element ** block = this->data;
+    if (new_rows < this->rows) {
+        memmove(block + new_rows, this->data[0], size * sizeof(matrix_element));
+        matrix_element ** shrunk = (matrix_element **)realloc(block,
+            new_rows * sizeof(matrix_element *) + size * sizeof(matrix_element));
+        if (NULL != shrunk) block = shrunk;
+    }
+    matrix_element * first_element = (matrix_element *)(block + new_rows);
+    for (size_t row = 0; row < new_rows; row++)
+        block[row] = first_element + row * new_cols;
+    this->data = block;
+    this->rows = new_rows;
+    this->cols = new_cols;
+}
+
+
+Matrix matrix_transposed(const Matrix * this) {
+    if (NULL == this->data) {
+        matrix_error_handler(NULL_MATRIX_ERROR, "matrix_transposed");
+        return NULL_MATRIX;
+    }
+    Matrix result = create_matrix(this->cols, this->rows);
+    if (NULL == result.data) {
+        matrix_error_handler(NULL_MATRIX_ERROR, "matrix_transposed");
+        return NULL_MATRIX;
+    }
+    transpose_recursive(this->data[0], this->cols, result.data[0], result.cols, this->rows, this->cols);
+    return result;
+}
+
+
 void matrix_transposition(Matrix * this) {
     if (NULL == this->data) {
         matrix_error_handler(NULL_MATRIX_ERROR, "matrix_transposition");
         return;
     }
-    Matrix buff = create_matrix(this->cols, this->rows);
-    if (NULL == buff.data) {
-        matrix_error_handler(NULL_MATRIX_ERROR, "matrix_transposition");
+    if (this->rows == this->cols) {
+        transpose_square_in_place(this->data[0], this->rows);
         return;
     }
-    size_t size = matrix_size(this);
+    unsigned char * visited = (unsigned char *)calloc(matrix_size(this) / 8 + 1, 1);
+    if (NULL == visited || !matrix_grow_row_pointers(this, this->cols)) {
+        free(visited);
+        matrix_error_handler(MALLOC_ERROR, "matrix_transposition");
+        return;
+    }
+    transpose_cycles_in_place(this->data[0], this->rows, this->cols, visited);
+    free(visited);
+    matrix_set_row_pointers(this, this->cols, this->rows);
+}
+
+
+static MatrixView create_matrix_view(const size_t rows, const size_t cols) {
+    MatrixView view = {.rows = rows, .cols = cols, .row_ptrs = NULL, .col_idx = NULL};
+    //  both index tables in one malloc, O(rows + cols) instead of a copy of the elements
+    size_t len = rows * sizeof(matrix_element *) + cols * sizeof(size_t);
+    if (len == 0) return view;
+    view.row_ptrs = (const matrix_element **)malloc(len);
+    if (NULL == view.row_ptrs) {
+        matrix_error_handler(MALLOC_ERROR, "create_matrix_view");
+        return NULL_VIEW;
+    }
+    view.col_idx = (size_t *)(view.row_ptrs + rows);
+    return view;
+}
+
+
+MatrixView matrix_view(const Matrix * this) {
+    return matrix_block_view(this, 0, this->rows, 0, this->cols);
+}
+
+
+MatrixView matrix_block_view(const Matrix * this, const size_t first_row, const size_t rows,
+                             const size_t first_col, const size_t cols) {
+    if (NULL == this->data) {
+        matrix_error_handler(NULL_MATRIX_ERROR, "matrix_block_view");
+        return NULL_VIEW;
+    }
+    if (first_row + rows > this->rows || first_col + cols > this->cols) {
+        matrix_error_handler(SIZE_ERROR, "matrix_block_view");
+        return NULL_VIEW;
+    }
+    MatrixView view = create_matrix_view(rows, cols);
+    if (NULL == view.row_ptrs) return NULL_VIEW;
+    for (size_t row = 0; row < rows; row++)
+        view.row_ptrs[row] = this->data[first_row + row];
+    for (size_t col = 0; col < cols; col++)
+        view.col_idx[col] = first_col + col;
+    return view;
+}
+
+
+//  skip one row and one column of a view; minors of minors stay O(n) each
+MatrixView matrix_minor_view(const MatrixView * this, const size_t row_to_skip, const size_t col_to_skip) {
+    if (NULL == this->row_ptrs) {
+        matrix_error_handler(NULL_MATRIX_ERROR, "matrix_minor_view");
+        return NULL_VIEW;
+    }
+    if (row_to_skip >= this->rows || col_to_skip >= this->cols) {
+        matrix_error_handler(SIZE_ERROR, "matrix_minor_view");
+        return NULL_VIEW;
+    }
+    MatrixView view = create_matrix_view(this->rows - 1, this->cols - 1);
+    if (NULL == view.row_ptrs && view.rows * view.cols != 0) return NULL_VIEW;
+    for (size_t row = 0; row < view.rows; row++)
+        view.row_ptrs[row] = this->row_ptrs[row + (row >= row_to_skip)];
+    for (size_t col = 0; col < view.cols; col++)
+        view.col_idx[col] = this->col_idx[col + (col >= col_to_skip)];
+    return view;
+}
+
+
+void delete_matrix_view(MatrixView * this) {
+    free(this->row_ptrs);
+    this->rows = 0;
+    this->cols = 0;
+    this->row_ptrs = NULL;
+    this->col_idx = NULL;
+}
+
+
+Matrix matrix_materialize(const MatrixView * this) {
+    if (NULL == this->row_ptrs) {
+        matrix_error_handler(NULL_MATRIX_ERROR, "matrix_materialize");
+        return NULL_MATRIX;
+    }
+    Matrix new_matrix = create_matrix(this->rows, this->cols);
+    if (NULL == new_matrix.data) return NULL_MATRIX;
+    bool contiguous = true;  //  block views copy whole row segments
+    for (size_t col = 1; col < this->cols; col++)
+        contiguous = contiguous && this->col_idx[col] == this->col_idx[0] + col;
     for (size_t row = 0; row < this->rows; row++) {
-        for (size_t col = 0; col < this->cols; col++) {
-            buff.data[col][row] = this->data[row][col];
+        if (contiguous) {
+            memcpy(new_matrix.data[row], this->row_ptrs[row] + this->col_idx[0], this->cols * sizeof(matrix_element));
+            continue;
         }
+        for (size_t col = 0; col < this->cols; col++)
+            new_matrix.data[row][col] = view_element(this, row, col);
     }
-    free(this->data);
-    this->data = buff.data;
-    this->rows = buff.rows;
-    this->cols = buff.cols;
+    return new_matrix;
 }
 
 
@@ -218,67 +496,155 @@ Matrix get_submatrix(const Matrix * this, const size_t row_to_delete, const size
         matrix_error_handler(NULL_MATRIX_ERROR, "get_submatrix");
         return NULL_MATRIX;
     }
-    size_t new_rows = this->rows - 1;
-    size_t new_cols = this->cols - 1;
-    size_t size = matrix_size(this);
-    Matrix new_matrix  = create_matrix(new_rows, new_cols);
+    MatrixView full = matrix_view(this);
+    MatrixView minor = matrix_minor_view(&full, row_to_delete, col_to_delete);
+    Matrix new_matrix = matrix_materialize(&minor);
+    delete_matrix_view(&minor);
+    delete_matrix_view(&full);
+    return new_matrix;
+}
+
+
+double matrix_determinant(const Matrix * this) {
+    if (NULL == this->data) {
+        matrix_error_handler(NULL_MATRIX_ERROR, "matrix_determinant");
+        return NAN;
+    }
+    MatrixView full = matrix_view(this);
+    double determinant = matrix_view_determinant(&full);
+    delete_matrix_view(&full);
+    return determinant;
+}
 
-    if (NULL == new_matrix.data) return NULL_MATRIX;
 
-    size_t new_size = matrix_size(&new_matrix);
-    matrix_element fill_data[new_size];
-    size_t new_data_counter = 0;
-    size_t row_index = 0;
-    for (size_t count = 0; count < size; count++) {
-        size_t col_index = count % this->cols;
-        if (row_index != row_to_delete & col_index != col_to_delete) {
-            fill_data[new_data_counter] = this->data[row_index][col_index];
-            new_data_counter++;
+double matrix_view_determinant(const MatrixView * this) {
+    if (this->rows != this->cols) {
+        matrix_error_handler(MATH_DOMAIN_ERROR, "matrix_view_determinant");
+        return NAN;
+    }
+    if (NULL == this->row_ptrs) {
+        matrix_error_handler(NULL_MATRIX_ERROR, "matrix_view_determinant");
+        return NAN;
+    }
+    size_t n = this->rows;
+    Matrix lu = create_matrix(n, n);  //  elimination scratch, gathered straight from the view
+    if (NULL == lu.data) {
+        matrix_error_handler(NULL_MATRIX_ERROR, "matrix_view_determinant");
+        return NAN;
+    }
+    for (size_t row = 0; row < n; row++)
+        for (size_t col = 0; col < n; col++)
+            lu.data[row][col] = view_element(this, row, col);
+
+    double determinant = 1;
+    for (size_t col = 0; col < n; col++) {
+        size_t pivot = col;
+        for (size_t row = col + 1; row < n; row++)
+            if (fabs(lu.data[row][col]) > fabs(lu.data[pivot][col])) pivot = row;
+        if (lu.data[pivot][col] == 0) {
+            determinant = 0;
+            break;
+        }
+        if (pivot != col) {  //  swap row pointers, not the rows
+            matrix_element * row_buff = lu.data[pivot];
+            lu.data[pivot] = lu.data[col];
+            lu.data[col] = row_buff;
+            determinant = -determinant;
         }
-        if (col_index + 1 == this->cols) {
-            row_index++;
+        matrix_element * pivot_row = lu.data[col];
+        determinant *= pivot_row[col];
+        for (size_t row = col + 1; row < n; row++) {
+            matrix_element * cur_row = lu.data[row];
+            matrix_element factor = cur_row[col] / pivot_row[col];
+            for (size_t idx = col + 1; idx < n; idx++)
+                cur_row[idx] -= factor * pivot_row[idx];
         }
     }
-    fill_with_data(&new_matrix, fill_data);
-    return new_matrix;
+#ifdef DEBUG
+    printf("[DEBUG] VIEW AT %p. DETERMINANT: %0.3f\n", this->row_ptrs, determinant);
+#endif
+    delete_matrix(&lu);
+    return determinant;
 }
 
 
-double matrix_determinant(const Matrix * this) {
+//  O(n!) cofactor expansion along row 0, kept as a reference for debugging
+double matrix_determinant_laplace(const Matrix * this) {
+    if (NULL == this->data) {
+        matrix_error_handler(NULL_MATRIX_ERROR, "matrix_determinant_laplace");
+        return NAN;
+    }
+    MatrixView full = matrix_view(this);
+    double determinant = matrix_view_determinant_laplace(&full);
+    delete_matrix_view(&full);
+    return determinant;
+}
+
+
+double matrix_view_determinant_laplace(const MatrixView * this) {
     if (this->rows != this->cols) {
-        matrix_error_handler(MATH_DOMAIN_ERROR, "martix_determinant");
-        return;
+        matrix_error_handler(MATH_DOMAIN_ERROR, "matrix_view_determinant_laplace");
+        return NAN;
     }
-    if (NULL == this->data) {
-        matrix_error_handler(NULL_MATRIX_ERROR, "matrix_determinant");
-        return;
+    if (NULL == this->row_ptrs) {
+        matrix_error_handler(NULL_MATRIX_ERROR, "matrix_view_determinant_laplace");
+        return NAN;
     } 
     switch (this->rows)
     {
     case 1:
-        return this->data[0][0];
+        return view_element(this, 0, 0);
         break;
     
     case 2:
-        return this->data[0][0] * this->data[1][1] - 
-                this->data[0][1] * this->data[1][0];
+        return view_element(this, 0, 0) * view_element(this, 1, 1) - 
+                view_element(this, 0, 1) * view_element(this, 1, 0);
         break;
     default:
         double determinant = 0;
         for (size_t col_counter = 0; col_counter < this->cols; col_counter++) {
-            Matrix submatrix = get_submatrix(this, 0, col_counter);
-            Matrix * temp = &submatrix;
-            determinant += this->data[0][col_counter] * pow(-1, col_counter) * matrix_determinant(temp);
-            delete_matrix(&submatrix);
+            MatrixView minor = matrix_minor_view(this, 0, col_counter);
+            double sign = (col_counter % 2 == 0) ? 1 : -1;
+            determinant += view_element(this, 0, col_counter) * sign * matrix_view_determinant_laplace(&minor);
+            delete_matrix_view(&minor);
         }
 #ifdef DEBUG
-        printf("[DEBUG] MATRIX AT %p. DETERMINANT: %0.3f\n", this->data, determinant);
+        printf("[DEBUG] VIEW AT %p. DETERMINANT: %0.3f\n", this->row_ptrs, determinant);
 #endif
         return determinant;
         break;
     }
 }
 
+
+Matrix matrix_view_multiplication(const MatrixView * view_1, const MatrixView * view_2) {
+    if (view_1->cols != view_2->rows) {
+        matrix_error_handler(MATH_DOMAIN_ERROR, "matrix_view_multiplication");
+        return NULL_MATRIX;
+    }
+    if (NULL == view_1->row_ptrs || NULL == view_2->row_ptrs) {
+        matrix_error_handler(NULL_MATRIX_ERROR, "matrix_view_multiplication");
+        return NULL_MATRIX;
+    }
+    Matrix new_matrix = create_matrix(view_1->rows, view_2->cols);
+    if (NULL == new_matrix.data) {
+        matrix_error_handler(NULL_MATRIX_ERROR, "matrix_view_multiplication");
+        return NULL_MATRIX;
+    }
+    memset(new_matrix.data[0], 0, matrix_size(&new_matrix) * sizeof(matrix_element));
+    for (size_t row = 0; row < new_matrix.rows; row++) {
+        matrix_element * out_row = new_matrix.data[row];
+        for (size_t idx = 0; idx < view_1->cols; idx++) {  //  i-k-j: the inner loop walks one row of view_2
+            matrix_element factor = view_element(view_1, row, idx);
+            const matrix_element * in_row = view_2->row_ptrs[idx];
+            for (size_t col = 0; col < new_matrix.cols; col++)
+                out_row[col] += factor * in_row[view_2->col_idx[col]];
+        }
+    }
+    return new_matrix;
+}
+
+
 Matrix matrix_multiplication(const Matrix * matrix_1, const Matrix * matrix_2) {
     if (matrix_1->cols != matrix_2->rows) {
         matrix_error_handler(MATH_DOMAIN_ERROR, "matrix_multiplication");
@@ -1,6 +1,154 @@
 #include "MatrixHandler.h"
+#include <math.h>
+#include <stdio.h>
 #include <string.h>
 
+
+//  deterministic entries, the same on every run
+Matrix sample_matrix(const size_t rows, const size_t cols, const double seed) {
+    Matrix A = create_matrix(rows, cols);
+    for (size_t row = 0; row < rows; row++)
+        for (size_t col = 0; col < cols; col++)
+            A.data[row][col] = sin(seed + 1.3 * row + 0.7 * col * col + 0.1 * row * col);
+    return A;
+}
+
+
+bool check(const char * name, const bool ok) {
+    printf("%s: %s\n", name, ok ? "OK" : "FAILED");
+    return ok;
+}
+
+
+//  LU against the cofactor expansion, for a full matrix, a singular one and
+//  one whose first pivot is zero so the row pointers have to be swapped
+bool check_determinant(void) {
+    Matrix A = sample_matrix(7, 7, 0.6);
+    Matrix copy = sample_matrix(7, 7, 0.6);
+    double lu = matrix_determinant(&A);
+    double laplace = matrix_determinant_laplace(&A);
+    bool ok = fabs(lu - laplace) <= 1e-12 * fabs(laplace) && fabs(laplace) > 1e-6;
+    for (size_t row = 0; row < 7; row++)  //  the elimination works on a copy
+        ok = ok && memcmp(A.data[row], copy.data[row], 7 * sizeof(matrix_element)) == 0;
+
+    Matrix singular = create_matrix(3, 3);
+    double singular_data[9] = {1, 2, 3, 2, 4, 6, 1, 0, 1};
+    fill_with_data(&singular, singular_data);
+    ok = ok && matrix_determinant(&singular) == 0 && matrix_determinant_laplace(&singular) == 0;
+
+    Matrix swapped = create_matrix(4, 4);
+    double swapped_data[16] = {0, 1, 2, 1, 3, 4, 5, 0, 6, 7, 9, 2, 1, 0, 2, 5};
+    fill_with_data(&swapped, swapped_data);
+    double swapped_laplace = matrix_determinant_laplace(&swapped);
+    ok = ok && fabs(matrix_determinant(&swapped) - swapped_laplace) < 1e-12 && swapped_laplace != 0;
+
+    delete_matrix(&A);
+    delete_matrix(&copy);
+    delete_matrix(&singular);
+    delete_matrix(&swapped);
+    return check("LU determinant against Laplace", ok);
+}
+
+
+bool same_matrix(const Matrix * matrix_1, const Matrix * matrix_2) {
+    if (matrix_1->rows != matrix_2->rows || matrix_1->cols != matrix_2->cols) return false;
+    for (size_t row = 0; row < matrix_1->rows; row++)
+        if (memcmp(matrix_1->data[row], matrix_2->data[row], matrix_1->cols * sizeof(matrix_element)) != 0)
+            return false;
+    return true;
+}
+
+
+//  copies and in-place transposes past the 4x4 tiles, square, tall and wide,
+//  where the in-place one follows cycles and moves the row pointers
+bool check_transpose(void) {
+    const size_t shapes[][2] = {{1, 1}, {3, 5}, {13, 7}, {17, 17}, {70, 33}, {2, 100}, {100, 1}};
+    bool ok = true;
+    for (size_t shape = 0; shape < sizeof(shapes) / sizeof(shapes[0]); shape++) {
+        size_t rows = shapes[shape][0], cols = shapes[shape][1];
+        Matrix A = sample_matrix(rows, cols, 0.2 * shape);
+        Matrix original = sample_matrix(rows, cols, 0.2 * shape);
+        Matrix T = matrix_transposed(&A);
+        ok = ok && T.rows == cols && T.cols == rows;
+        for (size_t row = 0; row < rows; row++)
+            for (size_t col = 0; col < cols; col++)
+                ok = ok && T.data[col][row] == A.data[row][col];
+
+        matrix_transposition(&A);
+        ok = ok && same_matrix(&A, &T);
+        for (size_t row = 0; row < A.rows; row++)  //  row pointers follow the new shape
+            ok = ok && A.data[row] == A.data[0] + row * A.cols;
+
+        matrix_transposition(&A);
+        Matrix back = matrix_transposed(&T);
+        ok = ok && same_matrix(&A, &original) && same_matrix(&back, &original);
+
+        delete_matrix(&A);
+        delete_matrix(&original);
+        delete_matrix(&T);
+        delete_matrix(&back);
+    }
+    return check("Transposes and their round trips", ok);
+}
+
+
+//  views against explicit copies: a block, a minor of a minor (not
+//  contiguous), their products and determinants, and an out-of-range block
+bool check_views(void) {
+    Matrix A = sample_matrix(9, 8, 1.1);
+    Matrix B = sample_matrix(8, 6, 2.7);
+
+    MatrixView block = matrix_block_view(&A, 2, 5, 1, 6);
+    Matrix block_copy = matrix_materialize(&block);
+    bool ok = block_copy.rows == 5 && block_copy.cols == 6;
+    for (size_t row = 0; row < 5; row++)
+        for (size_t col = 0; col < 6; col++)
+            ok = ok && block_copy.data[row][col] == A.data[row + 2][col + 1];
+
+    MatrixView square = matrix_block_view(&A, 1, 6, 2, 6);
+    MatrixView minor = matrix_minor_view(&square, 2, 1);
+    MatrixView minor_minor = matrix_minor_view(&minor, 0, 3);
+    Matrix minor_minor_copy = matrix_materialize(&minor_minor);
+    const size_t kept_rows[4] = {2, 4, 5, 6}, kept_cols[4] = {2, 4, 5, 7};
+    ok = ok && minor_minor_copy.rows == 4 && minor_minor_copy.cols == 4;
+    for (size_t row = 0; row < 4; row++)
+        for (size_t col = 0; col < 4; col++)
+            ok = ok && minor_minor_copy.data[row][col] == A.data[kept_rows[row]][kept_cols[col]];
+    double det = matrix_view_determinant(&minor_minor);
+    ok = ok && fabs(det - matrix_determinant_laplace(&minor_minor_copy)) <= 1e-12 * fabs(det);
+    ok = ok && fabs(det - matrix_view_determinant_laplace(&minor_minor)) <= 1e-12 * fabs(det);
+
+    //  a non-contiguous left operand times a block of B
+    MatrixView B_block = matrix_block_view(&B, 2, 4, 1, 5);
+    Matrix B_block_copy = matrix_materialize(&B_block);
+    Matrix product = matrix_view_multiplication(&minor_minor, &B_block);
+    Matrix expected = matrix_multiplication(&minor_minor_copy, &B_block_copy);
+    ok = ok && product.rows == 4 && product.cols == 5;
+    for (size_t row = 0; row < 4; row++)
+        for (size_t col = 0; col < 5; col++)
+            ok = ok && fabs(product.data[row][col] - expected.data[row][col]) < 1e-12;
+
+    MatrixView outside = matrix_block_view(&A, 5, 5, 0, 2);
+    ok = ok && outside.row_ptrs == NULL;
+    Matrix mismatched = matrix_view_multiplication(&block, &B_block);
+    ok = ok && mismatched.data == NULL;
+
+    delete_matrix_view(&block);
+    delete_matrix_view(&square);
+    delete_matrix_view(&minor);
+    delete_matrix_view(&minor_minor);
+    delete_matrix_view(&B_block);
+    delete_matrix(&A);
+    delete_matrix(&B);
+    delete_matrix(&block_copy);
+    delete_matrix(&minor_minor_copy);
+    delete_matrix(&B_block_copy);
+    delete_matrix(&product);
+    delete_matrix(&expected);
+    return check("Block and minor views", ok);
+}
+
+
 int main()
 {   
     Matrix A  = create_matrix(3, 4);
@@ -35,5 +183,9 @@ int main()
     delete_matrix(&C);
     delete_matrix(&D);
     delete_matrix(&E);
-    return 0;
+
+    bool ok = check_determinant();
+    ok = check_transpose() && ok;
+    ok = check_views() && ok;
+    return ok ? 0 : 1;
 }
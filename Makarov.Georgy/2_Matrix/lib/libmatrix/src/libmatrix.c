@@ -1,8 +1,16 @@
 #include "libmatrix.h"
+#include "threadpool.h"
 
 const struct Matrix MATRIX_NULL = {0, 0, NULL};
 const matrix_item RANDOM_LOW = -10., RANDOM_HIGH = 10.;
 
+// Output tile of one product task.
+const size_t PRODUCT_TILE_ROWS = 64;
+const size_t PRODUCT_TILE_COLS = 256;
+
+// Products with fewer multiply-adds stay on the calling thread.
+static size_t parallel_threshold = 128 * 128 * 128;
+
 
 void matrix_error(enum ErrorType error) {
     switch (error) {
@@ -36,7 +44,7 @@ struct Matrix matrix_allocate(const size_t rows, const size_t cols) {
         return MATRIX_NULL;
     }
 
-    struct Matrix M = {cols, rows, NULL};
+    struct Matrix M = {rows, cols, NULL};
 
     M.data = (matrix_item *) malloc(M.cols * M.rows * sizeof(matrix_item));
 
@@ -137,6 +145,23 @@ struct Matrix matrix_copy(const struct Matrix A, struct Matrix B) {
 }
 
 
+struct Matrix matrix_copy_into(struct Matrix C, const struct Matrix A) {
+    if (A.data == NULL || C.data == NULL) {
+        matrix_error(BAD_MATRIX_ERROR);
+        return MATRIX_NULL;
+    }
+
+    if (C.cols != A.cols || C.rows != A.rows) {
+        matrix_error(COLS_ROWS_ERROR);
+        return MATRIX_NULL;
+    }
+
+    if (C.data != A.data) memcpy(C.data, A.data, A.rows * A.cols * sizeof(matrix_item));
+
+    return C;
+}
+
+
 struct Matrix matrix_sum(const struct Matrix A, const struct Matrix B) {
     if (A.data == NULL || B.data == NULL) {
         matrix_error(BAD_MATRIX_ERROR);
@@ -152,6 +177,21 @@ struct Matrix matrix_sum(const struct Matrix A, const struct Matrix B) {
 
     if (C.data == NULL) return MATRIX_NULL;
 
+    return matrix_sum_into(C, A, B);
+}
+
+
+struct Matrix matrix_sum_into(struct Matrix C, const struct Matrix A, const struct Matrix B) {
+    if (A.data == NULL || B.data == NULL || C.data == NULL) {
+        matrix_error(BAD_MATRIX_ERROR);
+        return MATRIX_NULL;
+    }
+
+    if (A.cols != B.cols || A.rows != B.rows || C.cols != A.cols || C.rows != A.rows) {
+        matrix_error(COLS_ROWS_ERROR);
+        return MATRIX_NULL;
+    }
+
     for (size_t idx = 0; idx < A.cols * A.rows; ++idx) C.data[idx] = A.data[idx] + B.data[idx];
 
     return C;
@@ -173,12 +213,37 @@ struct Matrix matrix_subtract(const struct Matrix A, const struct Matrix B) {
 
     if (C.data == NULL) return MATRIX_NULL;
 
+    return matrix_subtract_into(C, A, B);
+}
+
+
+struct Matrix matrix_subtract_into(struct Matrix C, const struct Matrix A, const struct Matrix B) {
+    if (A.data == NULL || B.data == NULL || C.data == NULL) {
+        matrix_error(BAD_MATRIX_ERROR);
+        return MATRIX_NULL;
+    }
+
+    if (A.cols != B.cols || A.rows != B.rows || C.cols != A.cols || C.rows != A.rows) {
+        matrix_error(COLS_ROWS_ERROR);
+        return MATRIX_NULL;
+    }
+
     for (size_t idx = 0; idx < A.cols * A.rows; ++idx) C.data[idx] = A.data[idx] - B.data[idx];
 
     return C;
 }
 
 
+struct Matrix matrix_add_inplace(struct Matrix A, const struct Matrix B) {
+    return matrix_sum_into(A, A, B);
+}
+
+
+struct Matrix matrix_subtract_inplace(struct Matrix A, const struct Matrix B) {
+    return matrix_subtract_into(A, A, B);
+}
+
+
 struct Matrix matrix_multiply(const struct Matrix A, const double scalar) {
     if (A.data == NULL) {
         matrix_error(BAD_MATRIX_ERROR);
@@ -189,9 +254,78 @@ struct Matrix matrix_multiply(const struct Matrix A, const double scalar) {
 
     if (B.data == NULL) return MATRIX_NULL;
 
-    for (size_t idx = 0; idx < A.rows * A.cols; idx++) B.data[idx] = (matrix_item) scalar * A.data[idx];
+    return matrix_multiply_into(B, A, scalar);
+}
 
-    return B;
+
+struct Matrix matrix_multiply_into(struct Matrix C, const struct Matrix A, const double scalar) {
+    if (A.data == NULL || C.data == NULL) {
+        matrix_error(BAD_MATRIX_ERROR);
+        return MATRIX_NULL;
+    }
+
+    if (C.cols != A.cols || C.rows != A.rows) {
+        matrix_error(COLS_ROWS_ERROR);
+        return MATRIX_NULL;
+    }
+
+    for (size_t idx = 0; idx < A.rows * A.cols; idx++) C.data[idx] = (matrix_item) scalar * A.data[idx];
+
+    return C;
+}
+
+
+struct Matrix matrix_multiply_inplace(struct Matrix A, const double scalar) {
+    return matrix_multiply_into(A, A, scalar);
+}
+
+
+void matrix_set_threads(const size_t threads) {
+    threadpool_set_threads(threads);
+}
+
+
+size_t matrix_get_threads(void) {
+    return threadpool_get_threads();
+}
+
+
+void matrix_set_parallel_threshold(const size_t min_work) {
+    parallel_threshold = min_work;
+}
+
+
+struct ProductJob {
+    const struct Matrix *A;
+    const struct Matrix *B;
+    struct Matrix *C;
+    size_t tile_cols_count;
+};
+
+
+static void product_tile(void *context, size_t tile) {
+    const struct ProductJob *job = (const struct ProductJob *) context;
+    const struct Matrix *A = job->A;
+    const struct Matrix *B = job->B;
+    struct Matrix *C = job->C;
+
+    size_t row_begin = (tile / job->tile_cols_count) * PRODUCT_TILE_ROWS;
+    size_t col_begin = (tile % job->tile_cols_count) * PRODUCT_TILE_COLS;
+    size_t row_end = (row_begin + PRODUCT_TILE_ROWS < C->rows) ? row_begin + PRODUCT_TILE_ROWS : C->rows;
+    size_t col_end = (col_begin + PRODUCT_TILE_COLS < C->cols) ? col_begin + PRODUCT_TILE_COLS : C->cols;
+
+    for (size_t row = row_begin; row < row_end; row++) {
+        matrix_item *C_row = C->data + row * C->cols;
+
+        for (size_t col = col_begin; col < col_end; col++) C_row[col] = 0.;
+
+        for (size_t idx = 0; idx < A->cols; idx++) {
+            matrix_item factor = A->data[row * A->cols + idx];
+            const matrix_item *B_row = B->data + idx * B->cols;
+
+            for (size_t col = col_begin; col < col_end; col++) C_row[col] += factor * B_row[col];
+        }
+    }
 }
 
 
@@ -206,14 +340,35 @@ struct Matrix matrix_product(const struct Matrix A, const struct Matrix B) {
         return MATRIX_NULL;
     }
 
-    struct Matrix C = matrix_create(A.rows, A.cols, ZEROS);
+    struct Matrix C = matrix_allocate(A.rows, B.cols);
 
     if (C.data == NULL) return MATRIX_NULL;
 
-    for (size_t row_A = 0; row_A < A.rows; row_A++)
-        for (size_t col_B = 0; col_B < B.cols; col_B++)
-            for (size_t idx = 0; idx < A.cols; idx++)
-                C.data[row_A * A.cols + col_B] += A.data[row_A * A.cols + idx] * B.data[idx * B.cols + col_B];
+    return matrix_product_into(C, A, B);
+}
+
+
+struct Matrix matrix_product_into(struct Matrix C, const struct Matrix A, const struct Matrix B) {
+    if (A.data == NULL || B.data == NULL || C.data == NULL || C.data == A.data || C.data == B.data) {
+        matrix_error(BAD_MATRIX_ERROR);
+        return MATRIX_NULL;
+    }
+
+    if (A.cols != B.rows || C.rows != A.rows || C.cols != B.cols) {
+        matrix_error(COLS_ROWS_ERROR);
+        return MATRIX_NULL;
+    }
+
+    size_t tile_rows_count = (C.rows + PRODUCT_TILE_ROWS - 1) / PRODUCT_TILE_ROWS;
+    size_t tile_cols_count = (C.cols + PRODUCT_TILE_COLS - 1) / PRODUCT_TILE_COLS;
+    struct ProductJob job = {&A, &B, &C, tile_cols_count};
+
+    if (A.rows * A.cols * B.cols < parallel_threshold) {
+        for (size_t tile = 0; tile < tile_rows_count * tile_cols_count; tile++) product_tile(&job, tile);
+        return C;
+    }
+
+    threadpool_run(tile_rows_count * tile_cols_count, product_tile, &job);
 
     return C;
 }
@@ -229,10 +384,47 @@ struct Matrix matrix_transpose(const struct Matrix A) {
 
     if (B.data == NULL) return MATRIX_NULL;
 
+    return matrix_transpose_into(B, A);
+}
+
+
+struct Matrix matrix_transpose_into(struct Matrix C, const struct Matrix A) {
+    if (A.data == NULL || C.data == NULL || C.data == A.data) {
+        matrix_error(BAD_MATRIX_ERROR);
+        return MATRIX_NULL;
+    }
+
+    if (C.rows != A.cols || C.cols != A.rows) {
+        matrix_error(COLS_ROWS_ERROR);
+        return MATRIX_NULL;
+    }
+
     for (size_t row = 0; row < A.rows; row++)
-        for (size_t col = 0; col < A.cols; col++) B.data[col * A.rows + row] = A.data[row * A.cols + col];
+        for (size_t col = 0; col < A.cols; col++) C.data[col * A.rows + row] = A.data[row * A.cols + col];
 
-    return B;
+    return C;
+}
+
+
+struct Matrix matrix_transpose_inplace(struct Matrix A) {
+    if (A.data == NULL) {
+        matrix_error(BAD_MATRIX_ERROR);
+        return MATRIX_NULL;
+    }
+
+    if (A.rows != A.cols) {
+        matrix_error(COLS_ROWS_ERROR);
+        return MATRIX_NULL;
+    }
+
+    for (size_t row = 0; row < A.rows; row++)
+        for (size_t col = row + 1; col < A.cols; col++) {
+            matrix_item temp = A.data[row * A.cols + col];
+            A.data[row * A.cols + col] = A.data[col * A.cols + row];
+            A.data[col * A.cols + row] = temp;
+        }
+
+    return A;
 }
 
 
@@ -275,65 +467,121 @@ struct Matrix matrix_exp(const struct Matrix A, const unsigned int n) {
         return MATRIX_NULL;
     }
 
-    struct Matrix exponent = matrix_create(A.rows, A.cols, IDENTITY);
-    struct Matrix summand = matrix_create(A.rows, A.cols, IDENTITY);
-    struct Matrix temp = matrix_allocate(A.rows, A.cols);
-    if (exponent.data == NULL || summand.data == NULL || temp.data == NULL) {
-        matrix_free(&exponent);
-        matrix_free(&summand);
-        matrix_free(&temp);
+    struct Matrix exponent = matrix_allocate(A.rows, A.cols);
+    struct MatrixWorkspace W = matrix_workspace_allocate(matrix_exp_ws_size(A.rows));
+
+    if (exponent.data == NULL || W.data == NULL) {
+        if (exponent.data != NULL) matrix_free(&exponent);
+        matrix_workspace_free(&W);
         return MATRIX_NULL;
     }
 
-    if (n == 0) return exponent;
+    if (matrix_exp_ws(exponent, A, n, &W).data == NULL) matrix_free(&exponent);
 
-    if (n == 1) {
-        temp = matrix_sum(exponent, A);
-        if (temp.data == NULL) {
-            matrix_free(&exponent);
-            matrix_free(&summand);
-            matrix_free(&temp);
-            return MATRIX_NULL;
-        }
-        matrix_copy(temp, exponent);
-        matrix_free(&summand);
-        matrix_free(&temp);
-        return exponent;
+    matrix_workspace_free(&W);
+
+    return exponent;
+}
+
+
+struct MatrixWorkspace matrix_workspace_allocate(const size_t items) {
+    struct MatrixWorkspace W = {NULL, 0, 0, 0};
+
+    if (items == 0) return W;
+
+    if (items >= SIZE_MAX / sizeof(matrix_item)) {
+        matrix_error(MEMORY_ERROR);
+        return W;
+    }
+
+    W.data = (matrix_item *) malloc(items * sizeof(matrix_item));
+
+    if (W.data == NULL) {
+        matrix_error(MEMORY_ERROR);
+        return W;
+    }
+
+    W.capacity = items;
+
+    return W;
+}
+
+
+void matrix_workspace_free(struct MatrixWorkspace *W) {
+    free(W->data);
+    W->data = NULL;
+    W->capacity = 0;
+    W->used = 0;
+    W->high_water = 0;
+}
+
+
+struct Matrix matrix_workspace_take(struct MatrixWorkspace *W, const size_t rows, const size_t cols) {
+    if (rows == 0 || cols == 0) return MATRIX_NULL;
+
+    if (rows > (W->capacity - W->used) / cols) {
+        matrix_error(MEMORY_ERROR);
+        return MATRIX_NULL;
+    }
+
+    struct Matrix M = {rows, cols, W->data + W->used};
+
+    W->used += rows * cols;
+    if (W->used > W->high_water) W->high_water = W->used;
+
+    return M;
+}
+
+
+void matrix_workspace_reset(struct MatrixWorkspace *W) {
+    W->used = 0;
+}
+
+
+size_t matrix_workspace_high_water(const struct MatrixWorkspace *W) {
+    return W->high_water;
+}
+
+
+size_t matrix_exp_ws_size(const size_t n) {
+    return 2 * n * n;
+}
+
+
+struct Matrix matrix_exp_ws(struct Matrix E, const struct Matrix A, const unsigned int n, struct MatrixWorkspace *W) {
+    if (A.data == NULL || E.data == NULL || E.data == A.data) {
+        matrix_error(BAD_MATRIX_ERROR);
+        return MATRIX_NULL;
+    }
+
+    if (A.rows != A.cols || E.rows != A.rows || E.cols != A.cols) {
+        matrix_error(COLS_ROWS_ERROR);
+        return MATRIX_NULL;
     }
 
+    matrix_fill(&E, IDENTITY);
+
+    if (n == 0) return E;
+
+    // Scratch is handed back on return, so the caller's own takes survive
+    size_t mark = W->used;
+    struct Matrix summand = matrix_workspace_take(W, A.rows, A.cols);
+    struct Matrix temp = matrix_workspace_take(W, A.rows, A.cols);
+
+    if (summand.data == NULL || temp.data == NULL) {
+        W->used = mark;
+        return MATRIX_NULL;
+    }
+
+    matrix_fill(&summand, IDENTITY);
+
     for (unsigned int idx = 1; idx <= n; idx++) {
-        temp = matrix_product(summand, A);
-        if (temp.data == NULL) {
-            matrix_free(&exponent);
-            matrix_free(&summand);
-            matrix_free(&temp);
-            return MATRIX_NULL;
-        }
-        matrix_copy(temp, summand);
-        matrix_free(&temp);
-
-        temp = matrix_multiply(summand, 1. / idx);
-        if (temp.data == NULL) {
-            matrix_free(&exponent);
-            matrix_free(&summand);
-            matrix_free(&temp);
-            return MATRIX_NULL;
-        }
-        matrix_copy(temp, summand);
-        matrix_free(&temp);
-
-        temp = matrix_sum(exponent, summand);
-        if (temp.data == NULL) {
-            matrix_free(&exponent);
-            matrix_free(&summand);
-            matrix_free(&temp);
-            return MATRIX_NULL;
-        }
-        matrix_copy(temp, exponent);
-        matrix_free(&temp);
+        matrix_product_into(temp, summand, A);
+        matrix_multiply_into(summand, temp, 1. / idx);
+        matrix_sum_into(E, E, summand);
     }
 
-    matrix_free(&summand);
+    W->used = mark;
 
-    return exponent;
-}
\ No newline at end of file
+    return E;
+}
@@ -17,6 +17,16 @@ struct Matrix {
 };
 
 
+// Preallocated arena for scratch matrices. Matrices taken from it must not be
+// passed to matrix_free; the whole arena is released with matrix_workspace_free.
+struct MatrixWorkspace {
+    matrix_item *data;
+    size_t capacity;
+    size_t used;
+    size_t high_water;
+};
+
+
 enum MatrixType {
     ZEROS, ONES, RANDOM, IDENTITY
 };
@@ -48,10 +58,64 @@ struct Matrix matrix_multiply(const struct Matrix A, const double scalar);
 
 struct Matrix matrix_product(const struct Matrix A, const struct Matrix B);
 
+// Threads used by matrix_product, including the caller; 0 means one per online CPU.
+void matrix_set_threads(const size_t threads);
+
+size_t matrix_get_threads(void);
+
+// Products with fewer than min_work multiply-adds (rows * inner * cols) run serially.
+void matrix_set_parallel_threshold(const size_t min_work);
+
 struct Matrix matrix_transpose(const struct Matrix A);
 
 double matrix_det(const struct Matrix A);
 
 struct Matrix matrix_exp(const struct Matrix A, const unsigned int n);
 
+// Arena of `items` matrix items, allocated once and reused between calls.
+struct MatrixWorkspace matrix_workspace_allocate(const size_t items);
+
+void matrix_workspace_free(struct MatrixWorkspace *W);
+
+// Returns a rows x cols matrix backed by the arena, MATRIX_NULL when it does not fit.
+struct Matrix matrix_workspace_take(struct MatrixWorkspace *W, const size_t rows, const size_t cols);
+
+// Gives back every matrix taken from the arena; the high-water mark is kept.
+void matrix_workspace_reset(struct MatrixWorkspace *W);
+
+// Largest number of items the arena has had in use since it was allocated.
+size_t matrix_workspace_high_water(const struct MatrixWorkspace *W);
+
+// Items a workspace needs for matrix_exp_ws on an n x n matrix.
+size_t matrix_exp_ws_size(const size_t n);
+
+// Destination-passing forms: C must already have the result shape, they return C
+// or MATRIX_NULL on error. For the elementwise ones C may alias A or B; for
+// matrix_product_into and matrix_transpose_into it must not.
+struct Matrix matrix_sum_into(struct Matrix C, const struct Matrix A, const struct Matrix B);
+
+struct Matrix matrix_subtract_into(struct Matrix C, const struct Matrix A, const struct Matrix B);
+
+struct Matrix matrix_multiply_into(struct Matrix C, const struct Matrix A, const double scalar);
+
+struct Matrix matrix_product_into(struct Matrix C, const struct Matrix A, const struct Matrix B);
+
+struct Matrix matrix_transpose_into(struct Matrix C, const struct Matrix A);
+
+// Copies A into C of the same shape without reallocating.
+struct Matrix matrix_copy_into(struct Matrix C, const struct Matrix A);
+
+// In-place forms overwrite and return A.
+struct Matrix matrix_add_inplace(struct Matrix A, const struct Matrix B);
+
+struct Matrix matrix_subtract_inplace(struct Matrix A, const struct Matrix B);
+
+struct Matrix matrix_multiply_inplace(struct Matrix A, const double scalar);
+
+// Square matrices only.
+struct Matrix matrix_transpose_inplace(struct Matrix A);
+
+// Taylor series of exp(A) up to A^n / n! written into E, scratch comes from W.
+struct Matrix matrix_exp_ws(struct Matrix E, const struct Matrix A, const unsigned int n, struct MatrixWorkspace *W);
+
 #endif //LIBMATRIX_H
\ No newline at end of file
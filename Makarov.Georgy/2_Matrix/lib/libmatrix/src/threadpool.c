@@ -0,0 +1,167 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "threadpool.h"
+
+
+struct ThreadPool {
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+
+    pthread_t *workers;
+    size_t workers_count;
+    size_t threads;  // 0 until the first use
+    int shutdown;
+
+    unsigned long generation;
+    unsigned long start_generation;  // generation when the workers were created
+    threadpool_task task;
+    void *context;
+    size_t tasks;
+    size_t next_task;
+    size_t active;
+};
+
+
+static struct ThreadPool pool = {
+        PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER,
+        NULL, 0, 0, 0,
+        0, 0, NULL, NULL, 0, 0, 0
+};
+
+// Serializes callers of threadpool_run and threadpool_set_threads.
+static pthread_mutex_t submit_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+static size_t online_cpus(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cpus > 0) ? (size_t) cpus : 1;
+}
+
+
+// Must be called with pool.lock held, returns with it held.
+static void run_tasks(void) {
+    while (pool.next_task < pool.tasks) {
+        size_t task = pool.next_task++;
+
+        pthread_mutex_unlock(&pool.lock);
+        pool.task(pool.context, task);
+        pthread_mutex_lock(&pool.lock);
+    }
+}
+
+
+static void *worker_main(void *arg) {
+    (void) arg;
+    unsigned long seen = 0;
+
+    // Not pool.generation: a run may already have started before this thread
+    // got the lock, and it counts on this worker to finish
+    pthread_mutex_lock(&pool.lock);
+    seen = pool.start_generation;
+
+    for (;;) {
+        while (!pool.shutdown && pool.generation == seen)
+            pthread_cond_wait(&pool.work_ready, &pool.lock);
+
+        if (pool.shutdown) break;
+
+        seen = pool.generation;
+        run_tasks();
+
+        if (--pool.active == 0) pthread_cond_signal(&pool.work_done);
+    }
+
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+
+static void stop_workers(void) {
+    pthread_mutex_lock(&pool.lock);
+    pool.shutdown = 1;
+    pthread_cond_broadcast(&pool.work_ready);
+    pthread_mutex_unlock(&pool.lock);
+
+    for (size_t idx = 0; idx < pool.workers_count; idx++) pthread_join(pool.workers[idx], NULL);
+
+    free(pool.workers);
+    pool.workers = NULL;
+    pool.workers_count = 0;
+    pool.shutdown = 0;
+}
+
+
+static void start_workers(size_t threads) {
+    pool.threads = threads;
+    if (threads < 2) return;
+
+    pool.start_generation = pool.generation;
+
+    pool.workers = (pthread_t *) malloc((threads - 1) * sizeof(pthread_t));
+    if (pool.workers == NULL) {
+        pool.threads = 1;
+        return;
+    }
+
+    for (size_t idx = 0; idx < threads - 1; idx++) {
+        if (pthread_create(&pool.workers[idx], NULL, worker_main, NULL) != 0) break;
+        pool.workers_count++;
+    }
+
+    pool.threads = pool.workers_count + 1;
+}
+
+
+void threadpool_set_threads(size_t threads) {
+    if (threads == 0) threads = online_cpus();
+
+    pthread_mutex_lock(&submit_lock);
+    if (threads != pool.threads) {
+        stop_workers();
+        start_workers(threads);
+    }
+    pthread_mutex_unlock(&submit_lock);
+}
+
+
+size_t threadpool_get_threads(void) {
+    pthread_mutex_lock(&submit_lock);
+    if (pool.threads == 0) start_workers(online_cpus());
+    size_t threads = pool.threads;
+    pthread_mutex_unlock(&submit_lock);
+
+    return threads;
+}
+
+
+void threadpool_run(size_t tasks, threadpool_task task, void *context) {
+    pthread_mutex_lock(&submit_lock);
+    if (pool.threads == 0) start_workers(online_cpus());
+
+    if (pool.workers_count == 0 || tasks < 2) {
+        for (size_t idx = 0; idx < tasks; idx++) task(context, idx);
+        pthread_mutex_unlock(&submit_lock);
+        return;
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    pool.task = task;
+    pool.context = context;
+    pool.tasks = tasks;
+    pool.next_task = 0;
+    pool.active = pool.workers_count;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.work_ready);
+
+    run_tasks();
+
+    while (pool.active > 0) pthread_cond_wait(&pool.work_done, &pool.lock);
+
+    pool.task = NULL;
+    pool.context = NULL;
+    pthread_mutex_unlock(&pool.lock);
+
+    pthread_mutex_unlock(&submit_lock);
+}
@@ -0,0 +1,18 @@
+#ifndef LIBMATRIX_THREADPOOL_H
+#define LIBMATRIX_THREADPOOL_H
+
+#include <stddef.h>
+
+typedef void (*threadpool_task)(void *context, size_t task);
+
+// Resizes the persistent pool; the calling thread counts as one of the threads.
+// 0 means one thread per online CPU.
+void threadpool_set_threads(size_t threads);
+
+size_t threadpool_get_threads(void);
+
+// Runs task(context, 0) ... task(context, tasks - 1) on the pool and the calling
+// thread, returns when all of them are finished. Concurrent calls are serialized.
+void threadpool_run(size_t tasks, threadpool_task task, void *context);
+
+#endif //LIBMATRIX_THREADPOOL_H
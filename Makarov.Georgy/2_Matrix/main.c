@@ -1,5 +1,210 @@
 #include "libmatrix.h"
 
+
+// Deterministic entries, the same on every run
+struct Matrix sample(const size_t rows, const size_t cols, const double seed) {
+    struct Matrix M = matrix_allocate(rows, cols);
+    for (size_t row = 0; row < rows; row++)
+        for (size_t col = 0; col < cols; col++)
+            M.data[row * cols + col] = sin(seed + 1.3 * row + 0.7 * col * col + 0.1 * row * col);
+    return M;
+}
+
+
+double max_abs_diff(const struct Matrix A, const struct Matrix B) {
+    if (A.data == NULL || B.data == NULL || A.rows != B.rows || A.cols != B.cols) return INFINITY;
+
+    double diff = 0.;
+    for (size_t idx = 0; idx < A.rows * A.cols; idx++)
+        diff = fmax(diff, fabs(A.data[idx] - B.data[idx]));
+    return diff;
+}
+
+
+int check(const char *name, const int ok) {
+    printf("%s: %s\n", name, ok ? "OK" : "FAILED");
+    return ok;
+}
+
+
+// Tiled products on 1, 2 and all threads against a plain triple loop, for a
+// shape with partial tiles on both edges and for one below the threshold
+int check_parallel_product(void) {
+    const size_t shapes[][3] = {{150, 70, 300}, {20, 30, 40}};
+    const size_t thread_counts[] = {1, 2, 3, 0};
+    const size_t default_threshold = 128 * 128 * 128;
+    int ok = 1;
+
+    for (size_t shape = 0; shape < 2; shape++) {
+        size_t m = shapes[shape][0], k = shapes[shape][1], n = shapes[shape][2];
+        struct Matrix A = sample(m, k, 0.4);
+        struct Matrix B = sample(k, n, 1.8);
+        struct Matrix R = matrix_allocate(m, n);
+        for (size_t row = 0; row < m; row++)
+            for (size_t col = 0; col < n; col++) {
+                double sum = 0.;
+                for (size_t idx = 0; idx < k; idx++) sum += A.data[row * k + idx] * B.data[idx * n + col];
+                R.data[row * n + col] = sum;
+            }
+
+        matrix_set_threads(1);
+        struct Matrix serial = matrix_product(A, B);
+        ok = ok && max_abs_diff(serial, R) < 1e-12;
+
+        // Every tile runs the same loop wherever it is scheduled, so the
+        // parallel results have to match the serial one bit for bit
+        for (size_t idx = 0; idx < 4; idx++) {
+            matrix_set_threads(thread_counts[idx]);
+            ok = ok && (thread_counts[idx] == 0 ? matrix_get_threads() >= 1 : matrix_get_threads() == thread_counts[idx]);
+
+            matrix_set_parallel_threshold(0);
+            struct Matrix parallel = matrix_product(A, B);
+            matrix_set_parallel_threshold(default_threshold);
+            struct Matrix defaulted = matrix_product(A, B);
+
+            ok = ok && max_abs_diff(parallel, serial) == 0. && max_abs_diff(defaulted, serial) == 0.;
+            matrix_free(&parallel);
+            matrix_free(&defaulted);
+        }
+
+        matrix_free(&A);
+        matrix_free(&B);
+        matrix_free(&R);
+        matrix_free(&serial);
+    }
+
+    matrix_set_threads(0);
+    return check("matrix_product on 1, 2, 3 and all threads", ok);
+}
+
+
+// Frees the allocating result after comparing it with the destination form
+int same_and_free(struct Matrix result, struct Matrix expected) {
+    int ok = result.data != NULL && max_abs_diff(result, expected) == 0.;
+    matrix_free(&expected);
+    return ok;
+}
+
+
+// Every _into and _inplace form against the allocating one, including the
+// aliasing they allow, and the shape and aliasing errors they must report
+int check_destination_forms(void) {
+    const size_t m = 7, n = 5;
+    struct Matrix A = sample(m, n, 0.1);
+    struct Matrix B = sample(m, n, 2.2);
+    struct Matrix Bt = sample(n, m, 1.4);
+    struct Matrix S = sample(n, n, 3.1);
+    struct Matrix C = matrix_allocate(m, n);
+    struct Matrix P = matrix_allocate(m, m);
+    struct Matrix T = matrix_allocate(n, m);
+    struct Matrix wrong = matrix_allocate(n, n);
+
+    int ok = same_and_free(matrix_sum_into(C, A, B), matrix_sum(A, B));
+    ok = ok && same_and_free(matrix_subtract_into(C, A, B), matrix_subtract(A, B));
+    ok = ok && same_and_free(matrix_multiply_into(C, A, -1.5), matrix_multiply(A, -1.5));
+    ok = ok && same_and_free(matrix_product_into(P, A, Bt), matrix_product(A, Bt));
+    ok = ok && same_and_free(matrix_transpose_into(T, A), matrix_transpose(A));
+    ok = ok && matrix_copy_into(C, A).data == C.data && max_abs_diff(C, A) == 0.;
+
+    // Elementwise forms may write over an operand
+    ok = ok && same_and_free(matrix_add_inplace(C, B), matrix_sum(A, B));
+    matrix_copy_into(C, A);
+    ok = ok && same_and_free(matrix_subtract_inplace(C, B), matrix_subtract(A, B));
+    matrix_copy_into(C, A);
+    ok = ok && same_and_free(matrix_multiply_inplace(C, 0.25), matrix_multiply(A, 0.25));
+    matrix_copy_into(C, A);
+    ok = ok && same_and_free(matrix_sum_into(C, C, C), matrix_multiply(A, 2.));
+    struct Matrix St = matrix_transpose(S);
+    ok = ok && same_and_free(matrix_transpose_inplace(S), St);
+
+    // Wrong destination shapes, mismatched operands, and aliasing the
+    // product and the transpose cannot handle
+    ok = ok && matrix_sum_into(wrong, A, B).data == NULL && matrix_sum_into(C, A, Bt).data == NULL;
+    ok = ok && matrix_subtract_into(wrong, A, B).data == NULL && matrix_subtract_into(C, A, Bt).data == NULL;
+    ok = ok && matrix_multiply_into(wrong, A, 2.).data == NULL;
+    ok = ok && matrix_product_into(wrong, A, Bt).data == NULL && matrix_product_into(P, A, B).data == NULL;
+    ok = ok && matrix_transpose_into(C, A).data == NULL && matrix_copy_into(wrong, A).data == NULL;
+    ok = ok && matrix_add_inplace(A, Bt).data == NULL && matrix_subtract_inplace(A, Bt).data == NULL;
+    ok = ok && matrix_transpose_inplace(A).data == NULL;
+    ok = ok && matrix_product_into(S, S, S).data == NULL && matrix_transpose_into(S, S).data == NULL;
+    struct Matrix empty = {0, 0, NULL};
+    ok = ok && matrix_multiply_inplace(empty, 2.).data == NULL && matrix_sum_into(C, A, empty).data == NULL;
+
+    matrix_free(&A);
+    matrix_free(&B);
+    matrix_free(&Bt);
+    matrix_free(&S);
+    matrix_free(&C);
+    matrix_free(&P);
+    matrix_free(&T);
+    matrix_free(&wrong);
+
+    return check("_into and _inplace forms against the allocating ones", ok);
+}
+
+
+// matrix_exp_ws from one reused workspace against matrix_exp, a plain
+// Taylor loop and exp() on a diagonal, within matrix_exp_ws_size items
+int check_exp_workspace(void) {
+    const size_t n = 6;
+    const unsigned int terms = 25;
+    struct Matrix A = matrix_multiply_inplace(sample(n, n, 0.9), 0.3);
+    struct Matrix D = matrix_create(n, n, ZEROS);
+    for (size_t idx = 0; idx < n; idx++) D.data[idx * n + idx] = 0.5 * idx - 1.;
+
+    struct Matrix R = matrix_create(n, n, IDENTITY);
+    struct Matrix term = matrix_create(n, n, IDENTITY);
+    struct Matrix next = matrix_allocate(n, n);
+    for (unsigned int step = 1; step <= terms; step++) {
+        for (size_t row = 0; row < n; row++)
+            for (size_t col = 0; col < n; col++) {
+                double sum = 0.;
+                for (size_t idx = 0; idx < n; idx++) sum += term.data[row * n + idx] * A.data[idx * n + col];
+                next.data[row * n + col] = sum / step;
+            }
+        for (size_t idx = 0; idx < n * n; idx++) {
+            term.data[idx] = next.data[idx];
+            R.data[idx] += term.data[idx];
+        }
+    }
+
+    // One extra matrix taken up front must survive both calls
+    struct MatrixWorkspace W = matrix_workspace_allocate(n * n + matrix_exp_ws_size(n));
+    struct Matrix kept = matrix_workspace_take(&W, n, n);
+    matrix_fill(&kept, ONES);
+    struct Matrix E = matrix_allocate(n, n);
+    struct Matrix ED = matrix_allocate(n, n);
+    struct Matrix expected = matrix_exp(A, terms);
+
+    int ok = matrix_exp_ws(E, A, terms, &W).data == E.data && max_abs_diff(E, expected) == 0.;
+    ok = ok && max_abs_diff(E, R) < 1e-12;
+    ok = ok && matrix_exp_ws(ED, D, terms, &W).data == ED.data;
+    for (size_t row = 0; row < n; row++)
+        for (size_t col = 0; col < n; col++)
+            ok = ok && fabs(ED.data[row * n + col] - (row == col ? exp(D.data[row * n + col]) : 0.)) < 1e-12;
+
+    ok = ok && W.used == n * n && matrix_workspace_high_water(&W) <= n * n + matrix_exp_ws_size(n);
+    for (size_t idx = 0; idx < n * n; idx++) ok = ok && kept.data[idx] == 1.;
+
+    // One item short: the call fails and leaves the arena as it was
+    struct MatrixWorkspace small = matrix_workspace_allocate(matrix_exp_ws_size(n) - 1);
+    ok = ok && matrix_exp_ws(E, A, terms, &small).data == NULL && small.used == 0;
+
+    matrix_workspace_free(&small);
+    matrix_workspace_free(&W);
+    matrix_free(&A);
+    matrix_free(&D);
+    matrix_free(&R);
+    matrix_free(&term);
+    matrix_free(&next);
+    matrix_free(&E);
+    matrix_free(&ED);
+    matrix_free(&expected);
+
+    return check("matrix_exp_ws against matrix_exp and a Taylor loop", ok);
+}
+
+
 int main() {
     struct Matrix A = matrix_create(3, 3, RANDOM);
     struct Matrix B = matrix_create(3, 3, IDENTITY);
@@ -31,5 +236,9 @@ int main() {
     matrix_free(&C);
     matrix_free(&D);
 
-    return 0;
+    int ok = check_parallel_product();
+    ok = check_exp_workspace() && ok;
+    ok = check_destination_forms() && ok;
+
+    return ok ? 0 : 1;
 }
\ No newline at end of file
@@ -1,4 +1,9 @@
 #include "libmatrix.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
 
 
 void Matrix::fill(enum MatrixType matrix_type) {
@@ -141,8 +146,7 @@ Matrix Matrix::operator+(const Matrix &M) const {
     if (rows != M.rows || cols != M.cols) throw MatrixException("Matrix dimensions do not match");
 
     Matrix sum = {rows, cols, UNFILLED};
-    for (size_t idx = 0; idx < rows * cols; idx++)
-        sum.data[idx] = data[idx] + M.data[idx];
+    simd_kernels().add(data, M.data, sum.data, rows * cols);
     return sum;
 }
 
@@ -153,8 +157,7 @@ Matrix Matrix::operator-(const Matrix &M) const {
     if (rows != M.rows || cols != M.cols) throw MatrixException("Matrix dimensions do not match");
 
     Matrix sub = {rows, cols, UNFILLED};
-    for (size_t idx = 0; idx < rows * cols; idx++)
-        sub.data[idx] = data[idx] - M.data[idx];
+    simd_kernels().sub(data, M.data, sub.data, rows * cols);
     return sub;
 }
 
@@ -163,7 +166,7 @@ Matrix Matrix::operator*(double scalar) const {
     if (data == nullptr) throw MatrixException("Bad matrix error");
 
     Matrix product = {rows, cols, UNFILLED};
-    for (size_t idx = 0; idx < rows * cols; idx++) product.data[idx] = data[idx] * scalar;
+    simd_kernels().scale(data, scalar, product.data, rows * cols);
     return product;
 }
 
@@ -173,12 +176,8 @@ Matrix Matrix::operator*(const Matrix &M) const {
 
     if (cols != M.rows) throw MatrixException("Matrix outer dimensions do not match");
 
-    Matrix product = {rows, M.cols, ZEROS};
-    for (size_t this_row = 0; this_row < rows; this_row++)
-        for (size_t M_col = 0; M_col < M.cols; M_col++)
-            for (size_t idx = 0; idx < cols; idx++)
-                product.data[this_row * cols + M_col] +=
-                        data[this_row * cols + idx] * M.data[idx * M.cols + M_col];
+    Matrix product = {rows, M.cols, UNFILLED};
+    simd_kernels().product(data, M.data, product.data, rows, cols, M.cols);
     return product;
 }
 
@@ -188,7 +187,7 @@ void Matrix::operator+=(const Matrix &M) {
 
     if (rows != M.rows || cols != M.cols) throw MatrixException("Matrix dimensions do not match");
 
-    for (size_t idx = 0; idx < rows * cols; idx++) data[idx] += M.data[idx];
+    simd_kernels().add(data, M.data, data, rows * cols);
 }
 
 
@@ -197,14 +196,14 @@ void Matrix::operator-=(const Matrix &M) {
 
     if (rows != M.rows || cols != M.cols) throw MatrixException("Matrix dimensions do not match");
 
-    for (size_t idx = 0; idx < rows * cols; ++idx) data[idx] -= M.data[idx];
+    simd_kernels().sub(data, M.data, data, rows * cols);
 }
 
 
 void Matrix::operator*=(double scalar) {
     if (data == nullptr) throw MatrixException("Bad matrix error");
 
-    for (size_t idx = 0; idx < rows * cols; idx++) data[idx] *= scalar;
+    simd_kernels().scale(data, scalar, data, rows * cols);
 }
 
 
@@ -215,15 +214,10 @@ void Matrix::operator*=(const Matrix &M) {
     if (cols != M.rows)
         throw MatrixException("Matrix dimensions do not match for multiplication");
 
-    Matrix product{rows, M.cols, ZEROS};
+    Matrix product{rows, M.cols, UNFILLED};
+    simd_kernels().product(data, M.data, product.data, rows, cols, M.cols);
 
-    for (size_t this_row = 0; this_row < rows; this_row++)
-        for (size_t M_col = 0; M_col < M.cols; M_col++)
-            for (size_t idx = 0; idx < cols; idx++)
-                product.data[this_row * cols + M_col] +=
-                        data[this_row * cols + idx] * M.data[idx * M.cols + M_col];
-
-    *this = product;
+    *this = std::move(product);
 }
 
 
@@ -280,4 +274,581 @@ Matrix Matrix::exp(unsigned int n) const {
     }
 
     return exponent;
-}
\ No newline at end of file
+}
+
+
+BandedMatrix::BandedMatrix(size_t n_amount, size_t kl_amount, size_t ku_amount) {
+    if (n_amount == 0) return;
+
+    if (kl_amount >= n_amount || ku_amount >= n_amount) throw MatrixException("Band is wider than the matrix");
+
+    if (2 * kl_amount + ku_amount + 1 >= SIZE_MAX / sizeof(matrix_item) / n_amount)
+        throw MatrixException("Memory allocation error");
+
+    n = n_amount;
+    kl = kl_amount;
+    ku = ku_amount;
+    data = new matrix_item[ldab() * n];
+    memset(data, 0, ldab() * n * sizeof(matrix_item));
+}
+
+
+BandedMatrix::BandedMatrix(const Matrix &M, size_t kl_amount, size_t ku_amount)
+        : BandedMatrix(M.rows, kl_amount, ku_amount) {
+    if (M.rows != M.cols) throw MatrixException("Matrix should be square");
+
+    for (size_t col = 0; col < n; col++) {
+        size_t first = (col > ku) ? col - ku : 0;
+        size_t last = std::min(n - 1, col + kl);
+        for (size_t row = first; row <= last; row++)
+            data[col * ldab() + ku + row - col] = M.data[row * n + col];
+    }
+}
+
+
+BandedMatrix::BandedMatrix(const BandedMatrix &B) : n(B.n), kl(B.kl), ku(B.ku) {
+    if (B.data == nullptr) return;
+
+    data = new matrix_item[ldab() * n];
+    std::copy(B.data, B.data + ldab() * n, data);
+}
+
+
+BandedMatrix::BandedMatrix(BandedMatrix &&B) noexcept
+        : n(B.n), kl(B.kl), ku(B.ku), data(B.data), lu(B.lu), pivots(B.pivots), singular(B.singular) {
+    B.n = 0;
+    B.data = nullptr;
+    B.lu = nullptr;
+    B.pivots = nullptr;
+}
+
+
+BandedMatrix &BandedMatrix::operator=(const BandedMatrix &B) {
+    if (this == &B) return *this;
+
+    BandedMatrix copy(B);
+    return *this = std::move(copy);
+}
+
+
+BandedMatrix &BandedMatrix::operator=(BandedMatrix &&B) noexcept {
+    if (this == &B) return *this;
+
+    delete[] data;
+    drop_factors();
+    n = B.n;
+    kl = B.kl;
+    ku = B.ku;
+    data = B.data;
+    lu = B.lu;
+    pivots = B.pivots;
+    singular = B.singular;
+    B.n = 0;
+    B.data = nullptr;
+    B.lu = nullptr;
+    B.pivots = nullptr;
+    return *this;
+}
+
+
+void BandedMatrix::drop_factors() {
+    delete[] lu;
+    delete[] pivots;
+    lu = nullptr;
+    pivots = nullptr;
+    singular = false;
+}
+
+
+matrix_item BandedMatrix::get(size_t row, size_t col) const {
+    if (row >= n || col >= n) throw MatrixException("Out of range");
+
+    if (row > col + kl || col > row + ku) return 0.;
+    return data[col * ldab() + ku + row - col];
+}
+
+
+void BandedMatrix::set(size_t row, size_t col, matrix_item item) {
+    if (row >= n || col >= n) throw MatrixException("Out of range");
+
+    if (row > col + kl || col > row + ku) throw MatrixException("Element is outside the band");
+
+    drop_factors();
+    data[col * ldab() + ku + row - col] = item;
+}
+
+
+Matrix BandedMatrix::to_dense() const {
+    if (data == nullptr) throw MatrixException("Bad matrix error");
+
+    Matrix dense{n, n, ZEROS};
+    for (size_t col = 0; col < n; col++) {
+        size_t first = (col > ku) ? col - ku : 0;
+        size_t last = std::min(n - 1, col + kl);
+        for (size_t row = first; row <= last; row++)
+            dense.data[row * n + col] = data[col * ldab() + ku + row - col];
+    }
+    return dense;
+}
+
+
+Matrix BandedMatrix::operator*(const Matrix &M) const {
+    if (data == nullptr || M.data == nullptr) throw MatrixException("Bad matrix error");
+
+    if (n != M.rows) throw MatrixException("Matrix outer dimensions do not match");
+
+    size_t k = M.cols;
+    Matrix product{n, k, ZEROS};
+    for (size_t row = 0; row < n; row++) {
+        size_t first = (row > kl) ? row - kl : 0;
+        size_t last = std::min(n - 1, row + ku);
+        matrix_item *out = product.data + row * k;
+        for (size_t col = first; col <= last; col++) {
+            matrix_item factor = data[col * ldab() + ku + row - col];
+            const matrix_item *in = M.data + col * k;
+            for (size_t idx = 0; idx < k; idx++) out[idx] += factor * in[idx];
+        }
+    }
+    return product;
+}
+
+
+// Unblocked dgbtf2: element (row, col) of the factors lives at
+// lu[col * ldlu + kl + ku + row - col], so walking along a row steps by ldlu - 1.
+void BandedMatrix::factorize() {
+    if (lu != nullptr) return;
+
+    const size_t kv = kl + ku;
+    const size_t ld = ldlu();
+    const size_t step = ld - 1;
+    lu = new matrix_item[ld * n];
+    pivots = new size_t[n];
+    singular = false;
+
+    memset(lu, 0, ld * n * sizeof(matrix_item));
+    for (size_t col = 0; col < n; col++)
+        std::copy(data + col * ldab(), data + (col + 1) * ldab(), lu + col * ld + kl);
+
+    size_t last_col = 0;  // rightmost column touched by a row swap so far
+    for (size_t j = 0; j < n; j++) {
+        size_t below = std::min(kl, n - 1 - j);
+        matrix_item *diag = lu + j * ld + kv;
+
+        size_t pivot = 0;
+        for (size_t idx = 1; idx <= below; idx++)
+            if (std::fabs(diag[idx]) > std::fabs(diag[pivot])) pivot = idx;
+        pivots[j] = j + pivot;
+
+        if (diag[pivot] == 0.) {
+            singular = true;
+            continue;
+        }
+
+        last_col = std::max(last_col, std::min(j + ku + pivot, n - 1));
+
+        if (pivot != 0)
+            for (size_t idx = 0; idx <= last_col - j; idx++)
+                std::swap(diag[pivot + idx * step], diag[idx * step]);
+
+        matrix_item inv = 1. / diag[0];
+        for (size_t idx = 1; idx <= below; idx++) diag[idx] *= inv;
+
+        for (size_t col = 1; col <= last_col - j; col++) {
+            matrix_item *u = diag + col * step;  // (j, j + col), then the rows below it
+            matrix_item factor = u[0];
+            if (factor == 0.) continue;
+            for (size_t idx = 1; idx <= below; idx++) u[idx] -= diag[idx] * factor;
+        }
+    }
+}
+
+
+double BandedMatrix::det() {
+    if (data == nullptr) throw MatrixException("Bad matrix error");
+
+    factorize();
+    if (singular) return 0.;
+
+    double determinant = 1.;
+    for (size_t j = 0; j < n; j++) {
+        determinant *= lu[j * ldlu() + kl + ku];
+        if (pivots[j] != j) determinant = -determinant;
+    }
+    return determinant;
+}
+
+
+Matrix BandedMatrix::solve(const Matrix &B) {
+    if (data == nullptr || B.data == nullptr) throw MatrixException("Bad matrix error");
+
+    if (B.rows != n) throw MatrixException("Matrix dimensions do not match");
+
+    factorize();
+    if (singular) throw MatrixException("Matrix is singular");
+
+    const size_t kv = kl + ku;
+    const size_t ld = ldlu();
+    const size_t k = B.cols;
+    Matrix X{n, k, UNFILLED};
+    std::copy(B.data, B.data + n * k, X.data);
+    matrix_item *x = X.data;
+
+    // L: row swaps and unit lower columns, applied to all right-hand sides at once
+    for (size_t j = 0; j + 1 < n; j++) {
+        if (pivots[j] != j)
+            std::swap_ranges(x + j * k, x + (j + 1) * k, x + pivots[j] * k);
+        size_t below = std::min(kl, n - 1 - j);
+        const matrix_item *l = lu + j * ld + kv;
+        for (size_t idx = 1; idx <= below; idx++) {
+            matrix_item factor = l[idx];
+            matrix_item *dst = x + (j + idx) * k;
+            const matrix_item *src = x + j * k;
+            for (size_t rhs = 0; rhs < k; rhs++) dst[rhs] -= factor * src[rhs];
+        }
+    }
+
+    // U has kl + ku superdiagonals after the swaps
+    for (size_t j = n; j-- > 0;) {
+        const matrix_item *u = lu + j * ld;
+        matrix_item *src = x + j * k;
+        matrix_item inv = 1. / u[kv];
+        for (size_t rhs = 0; rhs < k; rhs++) src[rhs] *= inv;
+        size_t first = (j > kv) ? j - kv : 0;
+        for (size_t row = first; row < j; row++) {
+            matrix_item factor = u[kv + row - j];
+            matrix_item *dst = x + row * k;
+            for (size_t rhs = 0; rhs < k; rhs++) dst[rhs] -= factor * src[rhs];
+        }
+    }
+
+    return X;
+}
+
+
+Matrix BandedMatrix::solve_tridiagonal(const Matrix &B) const {
+    if (data == nullptr || B.data == nullptr) throw MatrixException("Bad matrix error");
+
+    if (kl != 1 || ku != 1) throw MatrixException("Matrix should be tridiagonal");
+
+    if (B.rows != n) throw MatrixException("Matrix dimensions do not match");
+
+    // column col holds (col - 1, col), (col, col), (col + 1, col)
+    auto sub = [this](size_t row) { return data[(row - 1) * 3 + 2]; };
+    auto diag = [this](size_t row) { return data[row * 3 + 1]; };
+    auto sup = [this](size_t row) { return data[(row + 1) * 3]; };
+
+    const size_t k = B.cols;
+    Matrix X{n, k, UNFILLED};
+    std::copy(B.data, B.data + n * k, X.data);
+    matrix_item *x = X.data;
+    matrix_item *c = new matrix_item[n];  // modified superdiagonal
+
+    matrix_item pivot = diag(0);
+    for (size_t row = 0; row < n; row++) {
+        if (row > 0) {
+            matrix_item factor = sub(row);
+            pivot = diag(row) - factor * c[row - 1];
+            for (size_t rhs = 0; rhs < k; rhs++) x[row * k + rhs] -= factor * x[(row - 1) * k + rhs];
+        }
+        if (pivot == 0.) {
+            delete[] c;
+            throw MatrixException("Zero pivot in the Thomas algorithm");
+        }
+        matrix_item inv = 1. / pivot;
+        c[row] = (row + 1 < n) ? sup(row) * inv : 0.;
+        for (size_t rhs = 0; rhs < k; rhs++) x[row * k + rhs] *= inv;
+    }
+
+    for (size_t row = n - 1; row-- > 0;)
+        for (size_t rhs = 0; rhs < k; rhs++) x[row * k + rhs] -= c[row] * x[(row + 1) * k + rhs];
+
+    delete[] c;
+    return X;
+}
+
+
+const size_t QR_BLOCK = 32;
+
+
+// Unblocked Householder QR of the m x nb panel at a (row stride lda): column j
+// ends with beta on the diagonal and v_j below it, v_j's leading 1 implied.
+static void qr_panel(matrix_item *a, size_t lda, size_t m, size_t nb, matrix_item *tau, matrix_item *w) {
+    for (size_t j = 0; j < nb; j++) {
+        tau[j] = 0.;
+        if (j >= m) continue;
+
+        matrix_item alpha = a[j * lda + j];
+        matrix_item tail = 0.;
+        for (size_t i = j + 1; i < m; i++) tail += a[i * lda + j] * a[i * lda + j];
+        if (tail == 0.) continue;
+
+        matrix_item beta = -std::copysign(std::sqrt(alpha * alpha + tail), alpha);
+        tau[j] = (beta - alpha) / beta;
+        matrix_item scale = 1. / (alpha - beta);
+        for (size_t i = j + 1; i < m; i++) a[i * lda + j] *= scale;
+        a[j * lda + j] = beta;
+
+        // H_j on the rest of the panel, streamed by rows: w = v^T * P, P -= tau * v * w
+        size_t rest = nb - j - 1;
+        if (rest == 0) continue;
+        std::copy(a + j * lda + j + 1, a + j * lda + nb, w);
+        for (size_t i = j + 1; i < m; i++) {
+            matrix_item v = a[i * lda + j];
+            const matrix_item *row = a + i * lda + j + 1;
+            for (size_t col = 0; col < rest; col++) w[col] += v * row[col];
+        }
+        for (size_t col = 0; col < rest; col++) w[col] *= tau[j];
+        for (size_t col = 0; col < rest; col++) a[j * lda + j + 1 + col] -= w[col];
+        for (size_t i = j + 1; i < m; i++) {
+            matrix_item v = a[i * lda + j];
+            matrix_item *row = a + i * lda + j + 1;
+            for (size_t col = 0; col < rest; col++) row[col] -= v * w[col];
+        }
+    }
+}
+
+
+// Element (i, p) of the panel's V: 1 on the diagonal, zero above it
+static matrix_item qr_v(const matrix_item *a, size_t lda, size_t i, size_t p) {
+    return (p == i) ? 1. : a[i * lda + p];
+}
+
+
+// T (nb x nb, upper) with H_0 * ... * H_{nb-1} = I - V * T * V^T, as LAPACK dlarft
+// does it but from G = V^T * V, which one pass over the rows of V gives.
+static void qr_block_t(const matrix_item *a, size_t lda, size_t m, size_t nb, const matrix_item *tau,
+                       matrix_item *t, matrix_item *g) {
+    std::fill(g, g + nb * nb, 0.);
+    for (size_t i = 0; i < m; i++) {
+        size_t last = std::min(i + 1, nb);
+        for (size_t p = 0; p < last; p++) {
+            matrix_item vp = qr_v(a, lda, i, p);
+            for (size_t q = p + 1; q < last; q++) g[p * nb + q] += vp * qr_v(a, lda, i, q);
+        }
+    }
+
+    std::fill(t, t + nb * nb, 0.);
+    for (size_t j = 0; j < nb; j++) {
+        t[j * nb + j] = tau[j];
+        for (size_t r = 0; r < j; r++) {
+            matrix_item sum = 0.;
+            for (size_t s = r; s < j; s++) sum += t[r * nb + s] * g[s * nb + j];
+            t[r * nb + j] = -tau[j] * sum;
+        }
+    }
+}
+
+
+// C = (I - V * T * V^T)^T * C for the m x ncols block at c, in two passes over
+// the rows: W = V^T * C, W = T^T * W, C -= V * W. w holds nb x ncols.
+static void qr_apply_block_t(const matrix_item *a, size_t lda, size_t m, size_t nb, const matrix_item *t,
+                             matrix_item *c, size_t ldc, size_t ncols, matrix_item *w) {
+    std::fill(w, w + nb * ncols, 0.);
+    for (size_t i = 0; i < m; i++) {
+        const matrix_item *c_row = c + i * ldc;
+        size_t last = std::min(i + 1, nb);
+        for (size_t p = 0; p < last; p++) {
+            matrix_item v = qr_v(a, lda, i, p);
+            matrix_item *w_row = w + p * ncols;
+            for (size_t col = 0; col < ncols; col++) w_row[col] += v * c_row[col];
+        }
+    }
+
+    // T^T is lower triangular, so rows of W are replaced from the bottom up
+    for (size_t p = nb; p-- > 0;) {
+        matrix_item *w_row = w + p * ncols;
+        for (size_t col = 0; col < ncols; col++) w_row[col] *= t[p * nb + p];
+        for (size_t q = 0; q < p; q++) {
+            matrix_item factor = t[q * nb + p];
+            const matrix_item *w_q = w + q * ncols;
+            for (size_t col = 0; col < ncols; col++) w_row[col] += factor * w_q[col];
+        }
+    }
+
+    for (size_t i = 0; i < m; i++) {
+        matrix_item *c_row = c + i * ldc;
+        size_t last = std::min(i + 1, nb);
+        for (size_t p = 0; p < last; p++) {
+            matrix_item v = qr_v(a, lda, i, p);
+            const matrix_item *w_row = w + p * ncols;
+            for (size_t col = 0; col < ncols; col++) c_row[col] -= v * w_row[col];
+        }
+    }
+}
+
+
+// Blocked QR of the m x n matrix at a in place. tau gets n items and
+// blocks_t the T of every block (QR_BLOCK^2 items each), when not null.
+static void qr_factor(matrix_item *a, size_t m, size_t n, matrix_item *tau, matrix_item *blocks_t) {
+    std::vector<matrix_item> t(QR_BLOCK * QR_BLOCK);
+    std::vector<matrix_item> g(QR_BLOCK * QR_BLOCK);
+    std::vector<matrix_item> w(QR_BLOCK * std::max<size_t>(n, 1));
+
+    for (size_t k0 = 0; k0 < n && k0 < m; k0 += QR_BLOCK) {
+        size_t nb = std::min(QR_BLOCK, n - k0);
+        matrix_item *panel = a + k0 * n + k0;
+        qr_panel(panel, n, m - k0, nb, tau + k0, w.data());
+
+        matrix_item *block_t = (blocks_t != nullptr) ? blocks_t + (k0 / QR_BLOCK) * QR_BLOCK * QR_BLOCK : t.data();
+        qr_block_t(panel, n, m - k0, nb, tau + k0, block_t, g.data());
+
+        if (k0 + nb < n)
+            qr_apply_block_t(panel, n, m - k0, nb, block_t, panel + nb, n, n - k0 - nb, w.data());
+    }
+}
+
+
+// X (n x k, stride ldx) = R^-1 * Y for the upper triangle R (stride ldr), in place
+static void qr_back_substitute(const matrix_item *r, size_t ldr, size_t n, matrix_item *x, size_t ldx, size_t k) {
+    for (size_t row = n; row-- > 0;) {
+        matrix_item diag = r[row * ldr + row];
+        if (diag == 0.) throw MatrixException("Matrix is rank deficient");
+
+        matrix_item *x_row = x + row * ldx;
+        for (size_t col = row + 1; col < n; col++) {
+            matrix_item factor = r[row * ldr + col];
+            const matrix_item *x_col = x + col * ldx;
+            for (size_t rhs = 0; rhs < k; rhs++) x_row[rhs] -= factor * x_col[rhs];
+        }
+        for (size_t rhs = 0; rhs < k; rhs++) x_row[rhs] /= diag;
+    }
+}
+
+
+HouseholderQR::HouseholderQR(const Matrix &A) : m(A.rows), n(A.cols) {
+    if (A.data == nullptr) throw MatrixException("Bad matrix error");
+
+    if (m < n) throw MatrixException("Matrix should have at least as many rows as columns");
+
+    size_t blocks = (n + QR_BLOCK - 1) / QR_BLOCK;
+    factors = new matrix_item[m * n];
+    tau = new matrix_item[n];
+    blocks_t = new matrix_item[blocks * QR_BLOCK * QR_BLOCK];
+    std::copy(A.data, A.data + m * n, factors);
+    qr_factor(factors, m, n, tau, blocks_t);
+}
+
+
+Matrix HouseholderQR::R() const {
+    Matrix r{n, n, ZEROS};
+    for (size_t row = 0; row < n; row++)
+        std::copy(factors + row * n + row, factors + (row + 1) * n, r.data + row * n + row);
+    return r;
+}
+
+
+Matrix HouseholderQR::apply_qt(const Matrix &B) const {
+    if (B.data == nullptr) throw MatrixException("Bad matrix error");
+
+    if (B.rows != m) throw MatrixException("Matrix dimensions do not match");
+
+    size_t k = B.cols;
+    Matrix qtb{m, k, UNFILLED};
+    std::copy(B.data, B.data + m * k, qtb.data);
+
+    std::vector<matrix_item> w(QR_BLOCK * k);
+    for (size_t k0 = 0; k0 < n; k0 += QR_BLOCK) {
+        size_t nb = std::min(QR_BLOCK, n - k0);
+        const matrix_item *block_t = blocks_t + (k0 / QR_BLOCK) * QR_BLOCK * QR_BLOCK;
+        qr_apply_block_t(factors + k0 * n + k0, n, m - k0, nb, block_t, qtb.data + k0 * k, k, k, w.data());
+    }
+    return qtb;
+}
+
+
+Matrix HouseholderQR::solve(const Matrix &B) const {
+    Matrix qtb = apply_qt(B);
+
+    size_t k = B.cols;
+    Matrix x{n, k, UNFILLED};
+    std::copy(qtb.data, qtb.data + n * k, x.data);
+    qr_back_substitute(factors, n, n, x.data, k, k);
+    return x;
+}
+
+
+Matrix solve_least_squares(const Matrix &A, const Matrix &B) {
+    return HouseholderQR(A).solve(B);
+}
+
+
+// QR of the rows stacked in buf (rows x w), leaving their w x w triangle in
+// the first w rows of buf with zeros below the diagonal. Returns its row count.
+static size_t tsqr_reduce(matrix_item *buf, size_t rows, size_t w, matrix_item *tau) {
+    qr_factor(buf, rows, w, tau, nullptr);
+
+    size_t kept = std::min(rows, w);
+    for (size_t row = 0; row < kept; row++) std::fill(buf + row * w, buf + row * w + row, 0.);
+    return kept;
+}
+
+
+Matrix solve_least_squares_tsqr(const Matrix &A, const Matrix &B, size_t threads) {
+    if (A.data == nullptr || B.data == nullptr) throw MatrixException("Bad matrix error");
+
+    if (A.rows != B.rows) throw MatrixException("Matrix dimensions do not match");
+
+    if (A.rows < A.cols) throw MatrixException("Matrix should have at least as many rows as columns");
+
+    const size_t m = A.rows;
+    const size_t n = A.cols;
+    const size_t k = B.cols;
+    const size_t w = n + k;  // R of [A | B] holds R and the top of Q^T * B
+    const size_t chunk = std::max<size_t>(256, 4 * w);  // rows copied per streaming step
+
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max<size_t>(1, std::min(threads, m / w));
+
+    // Every thread keeps a w x w triangle; row ranges are as even as possible
+    std::vector<std::vector<matrix_item>> triangles(threads, std::vector<matrix_item>(w * w, 0.));
+    auto stream_rows = [&](size_t part) {
+        size_t first = m * part / threads;
+        size_t last = m * (part + 1) / threads;
+        std::vector<matrix_item> buf((w + chunk) * w);
+        std::vector<matrix_item> tau(w);
+        size_t kept = 0;
+
+        for (size_t row0 = first; row0 < last; row0 += chunk) {
+            size_t count = std::min(chunk, last - row0);
+            for (size_t row = 0; row < count; row++) {
+                matrix_item *dst = buf.data() + (kept + row) * w;
+                std::copy(A.data + (row0 + row) * n, A.data + (row0 + row + 1) * n, dst);
+                std::copy(B.data + (row0 + row) * k, B.data + (row0 + row + 1) * k, dst + n);
+            }
+            kept = tsqr_reduce(buf.data(), kept + count, w, tau.data());
+        }
+        std::copy(buf.data(), buf.data() + kept * w, triangles[part].data());
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t part = 1; part < threads; part++) workers.emplace_back(stream_rows, part);
+    stream_rows(0);
+    for (std::thread &worker : workers) worker.join();
+
+    // Pairwise tree: stack two triangles, keep the triangle of their QR
+    for (size_t step = 1; step < threads; step *= 2) {
+        std::vector<std::thread> mergers;
+        auto merge = [&](size_t left) {
+            std::vector<matrix_item> buf(2 * w * w);
+            std::vector<matrix_item> tau(w);
+            std::copy(triangles[left].begin(), triangles[left].end(), buf.begin());
+            std::copy(triangles[left + step].begin(), triangles[left + step].end(), buf.begin() + w * w);
+            tsqr_reduce(buf.data(), 2 * w, w, tau.data());
+            std::copy(buf.begin(), buf.begin() + w * w, triangles[left].begin());
+        };
+        for (size_t left = 0; left + step < threads; left += 2 * step) mergers.emplace_back(merge, left);
+        for (std::thread &merger : mergers) merger.join();
+    }
+
+    // [R11 R12] on top: X = R11^-1 * R12
+    const matrix_item *r = triangles[0].data();
+    Matrix x{n, k, UNFILLED};
+    for (size_t row = 0; row < n; row++) std::copy(r + row * w + n, r + (row + 1) * w, x.data + row * k);
+    qr_back_substitute(r, w, n, x.data, k, k);
+    return x;
+}
+
+
+const char *matrix_simd_level() {
+    return simd_level_name(simd_level());
+}
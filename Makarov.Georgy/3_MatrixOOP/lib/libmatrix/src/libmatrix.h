@@ -56,6 +56,89 @@ public:
     double det();
     Matrix exp(unsigned int n = 100) const;
     ~Matrix() { delete[] data; }  // deleting null pointer has no effect
+
+    friend class BandedMatrix;
+    friend class HouseholderQR;
+    friend Matrix solve_least_squares_tsqr(const Matrix &A, const Matrix &B, size_t threads);
+};
+
+
+// n x n matrix with kl sub- and ku superdiagonals in LAPACK band storage:
+// element (row, col) sits at data[col * (kl + ku + 1) + ku + row - col], column-major,
+// so memory is O(n * (kl + ku)) instead of n^2.
+class BandedMatrix {
+private:
+    size_t n{0};
+    size_t kl{0};
+    size_t ku{0};
+    matrix_item *data{nullptr};
+    // LU factors as LAPACK dgbtrf leaves them: kl extra superdiagonals for
+    // the fill-in of row swaps. Built on demand, dropped by set().
+    matrix_item *lu{nullptr};
+    size_t *pivots{nullptr};
+    bool singular{false};
+private:
+    size_t ldab() const { return kl + ku + 1; }
+    size_t ldlu() const { return 2 * kl + ku + 1; }
+    void factorize();
+    void drop_factors();
+public:
+    BandedMatrix() = default;
+    BandedMatrix(size_t n, size_t kl, size_t ku);  // all zeros
+    BandedMatrix(const Matrix &M, size_t kl, size_t ku);  // the band of a square M
+    BandedMatrix(const BandedMatrix &B);
+    BandedMatrix(BandedMatrix &&B) noexcept;
+    BandedMatrix &operator=(const BandedMatrix &B);
+    BandedMatrix &operator=(BandedMatrix &&B) noexcept;
+    ~BandedMatrix() { delete[] data; drop_factors(); }
+    size_t size() const { return n; }
+    size_t lower() const { return kl; }
+    size_t upper() const { return ku; }
+    matrix_item get(size_t row, size_t col) const;  // zero outside the band
+    void set(size_t row, size_t col, matrix_item item);  // throws outside the band
+    Matrix to_dense() const;
+    Matrix operator*(const Matrix &M) const;  // O(n * (kl + ku + 1) * M.cols)
+    // Both go through a pivoted band LU, O(n * kl * (kl + ku)), computed once and kept
+    double det();
+    Matrix solve(const Matrix &B);  // X with A * X = B, B is n x k
+    // Thomas algorithm for kl = ku = 1 without pivoting, O(n * k); needs a
+    // diagonally dominant or otherwise safely factorable matrix
+    Matrix solve_tridiagonal(const Matrix &B) const;
 };
 
+
+// A = Q * R for an m x n A with m >= n by blocked Householder reflections.
+// Every block of QR_BLOCK reflections is kept in compact WY form,
+// I - V * T * V^T, so its update of the trailing columns is two
+// matrix products instead of one rank-1 update per column.
+class HouseholderQR {
+private:
+    size_t m{0};
+    size_t n{0};
+    matrix_item *factors{nullptr};  // R on and above the diagonal, the vectors of V below it
+    matrix_item *tau{nullptr};
+    matrix_item *blocks_t{nullptr};  // T of every block, QR_BLOCK x QR_BLOCK each
+public:
+    explicit HouseholderQR(const Matrix &A);
+    HouseholderQR(const HouseholderQR &) = delete;
+    HouseholderQR &operator=(const HouseholderQR &) = delete;
+    ~HouseholderQR() { delete[] factors; delete[] tau; delete[] blocks_t; }
+    Matrix R() const;  // n x n
+    Matrix apply_qt(const Matrix &B) const;  // Q^T * B for an m x k B
+    Matrix solve(const Matrix &B) const;  // least-squares X minimizing ||A * X - B||
+};
+
+// min ||A * X - B|| over X for a tall A, without forming A^T * A
+Matrix solve_least_squares(const Matrix &A, const Matrix &B);
+
+// Same for very tall, skinny A (say 10^7 x 50): [A | B] is cut into row
+// ranges, each thread streams its range through a small QR keeping only the
+// (n + k) x (n + k) triangle, and the triangles are merged pairwise in a tree.
+// Memory beyond A and B is O(threads * (n + k)^2). threads = 0 uses all cores.
+Matrix solve_least_squares_tsqr(const Matrix &A, const Matrix &B, size_t threads = 0);
+
+// Name of the SIMD kernels in use: "scalar", "sse2", "avx2" or "avx512".
+// Set LIBMATRIX_SIMD to one of these names to force a lower level.
+const char *matrix_simd_level();
+
 #endif //LIBMATRIX_H
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef LIBMATRIX_SIMD_H
+#define LIBMATRIX_SIMD_H
+
+#include <cstddef>
+
+// Instruction set levels, ordered from the weakest to the strongest.
+enum SimdLevel {
+    SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512
+};
+
+// Kernel table of one level. All matrices are dense and row-major.
+struct SimdKernels {
+    void (*add)(const double *a, const double *b, double *out, size_t n);
+    void (*sub)(const double *a, const double *b, double *out, size_t n);
+    void (*scale)(const double *a, double scalar, double *out, size_t n);
+    // out[m x n] = a[m x k] * b[k x n], out must not alias a or b
+    void (*product)(const double *a, const double *b, double *out, size_t m, size_t k, size_t n);
+};
+
+extern const SimdKernels scalar_kernels;
+#ifdef LIBMATRIX_X86
+extern const SimdKernels sse2_kernels;
+extern const SimdKernels avx2_kernels;
+extern const SimdKernels avx512_kernels;
+#endif
+
+// Best level supported by the CPU, or the one forced with
+// LIBMATRIX_SIMD=scalar|sse2|avx2|avx512 (clamped to what the CPU supports).
+SimdLevel simd_level();
+const char *simd_level_name(SimdLevel level);
+const SimdKernels &simd_kernels();
+
+
+// Shared blocking of the product kernels: for every row of out,
+// row_axpy(alpha, b_row, out_row, len) does out_row += alpha * b_row.
+// Kept static so every kernel file gets its own copy built with its own flags.
+const size_t SIMD_BLOCK_K = 128;
+const size_t SIMD_BLOCK_N = 512;
+
+template<typename RowAxpy>
+static inline void blocked_product(const double *a, const double *b, double *out,
+                            size_t m, size_t k, size_t n, RowAxpy row_axpy) {
+    for (size_t idx = 0; idx < m * n; idx++) out[idx] = 0.;
+
+    for (size_t col0 = 0; col0 < n; col0 += SIMD_BLOCK_N) {
+        size_t len = (n - col0 < SIMD_BLOCK_N) ? n - col0 : SIMD_BLOCK_N;
+
+        for (size_t k0 = 0; k0 < k; k0 += SIMD_BLOCK_K) {
+            size_t k1 = (k - k0 < SIMD_BLOCK_K) ? k : k0 + SIMD_BLOCK_K;
+
+            for (size_t row = 0; row < m; row++)
+                for (size_t idx = k0; idx < k1; idx++)
+                    row_axpy(a[row * k + idx], b + idx * n + col0, out + row * n + col0, len);
+        }
+    }
+}
+
+#endif //LIBMATRIX_SIMD_H
@@ -0,0 +1,48 @@
+#include <immintrin.h>
+#include "simd.h"
+
+
+static void add(const double *a, const double *b, double *out, size_t n) {
+    size_t idx = 0;
+    for (; idx + 4 <= n; idx += 4)
+        _mm256_storeu_pd(out + idx, _mm256_add_pd(_mm256_loadu_pd(a + idx), _mm256_loadu_pd(b + idx)));
+    for (; idx < n; idx++) out[idx] = a[idx] + b[idx];
+}
+
+
+static void sub(const double *a, const double *b, double *out, size_t n) {
+    size_t idx = 0;
+    for (; idx + 4 <= n; idx += 4)
+        _mm256_storeu_pd(out + idx, _mm256_sub_pd(_mm256_loadu_pd(a + idx), _mm256_loadu_pd(b + idx)));
+    for (; idx < n; idx++) out[idx] = a[idx] - b[idx];
+}
+
+
+static void scale(const double *a, double scalar, double *out, size_t n) {
+    __m256d factor = _mm256_set1_pd(scalar);
+    size_t idx = 0;
+    for (; idx + 4 <= n; idx += 4)
+        _mm256_storeu_pd(out + idx, _mm256_mul_pd(_mm256_loadu_pd(a + idx), factor));
+    for (; idx < n; idx++) out[idx] = a[idx] * scalar;
+}
+
+
+static void row_axpy(double alpha, const double *b, double *out, size_t len) {
+    __m256d factor = _mm256_set1_pd(alpha);
+    size_t idx = 0;
+    for (; idx + 8 <= len; idx += 8) {
+        __m256d lo = _mm256_fmadd_pd(factor, _mm256_loadu_pd(b + idx), _mm256_loadu_pd(out + idx));
+        __m256d hi = _mm256_fmadd_pd(factor, _mm256_loadu_pd(b + idx + 4), _mm256_loadu_pd(out + idx + 4));
+        _mm256_storeu_pd(out + idx, lo);
+        _mm256_storeu_pd(out + idx + 4, hi);
+    }
+    for (; idx < len; idx++) out[idx] += alpha * b[idx];
+}
+
+
+static void product(const double *a, const double *b, double *out, size_t m, size_t k, size_t n) {
+    blocked_product(a, b, out, m, k, n, row_axpy);
+}
+
+
+const SimdKernels avx2_kernels = {add, sub, scale, product};
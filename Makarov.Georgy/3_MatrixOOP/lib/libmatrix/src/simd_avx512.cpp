@@ -0,0 +1,70 @@
+#include <immintrin.h>
+#include "simd.h"
+
+
+static __mmask8 tail_mask(size_t rest) {
+    return (__mmask8) ((1u << rest) - 1);
+}
+
+
+static void add(const double *a, const double *b, double *out, size_t n) {
+    size_t idx = 0;
+    for (; idx + 8 <= n; idx += 8)
+        _mm512_storeu_pd(out + idx, _mm512_add_pd(_mm512_loadu_pd(a + idx), _mm512_loadu_pd(b + idx)));
+    if (idx < n) {
+        __mmask8 mask = tail_mask(n - idx);
+        __m512d sum = _mm512_add_pd(_mm512_maskz_loadu_pd(mask, a + idx), _mm512_maskz_loadu_pd(mask, b + idx));
+        _mm512_mask_storeu_pd(out + idx, mask, sum);
+    }
+}
+
+
+static void sub(const double *a, const double *b, double *out, size_t n) {
+    size_t idx = 0;
+    for (; idx + 8 <= n; idx += 8)
+        _mm512_storeu_pd(out + idx, _mm512_sub_pd(_mm512_loadu_pd(a + idx), _mm512_loadu_pd(b + idx)));
+    if (idx < n) {
+        __mmask8 mask = tail_mask(n - idx);
+        __m512d diff = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, a + idx), _mm512_maskz_loadu_pd(mask, b + idx));
+        _mm512_mask_storeu_pd(out + idx, mask, diff);
+    }
+}
+
+
+static void scale(const double *a, double scalar, double *out, size_t n) {
+    __m512d factor = _mm512_set1_pd(scalar);
+    size_t idx = 0;
+    for (; idx + 8 <= n; idx += 8)
+        _mm512_storeu_pd(out + idx, _mm512_mul_pd(_mm512_loadu_pd(a + idx), factor));
+    if (idx < n) {
+        __mmask8 mask = tail_mask(n - idx);
+        _mm512_mask_storeu_pd(out + idx, mask, _mm512_mul_pd(_mm512_maskz_loadu_pd(mask, a + idx), factor));
+    }
+}
+
+
+static void row_axpy(double alpha, const double *b, double *out, size_t len) {
+    __m512d factor = _mm512_set1_pd(alpha);
+    size_t idx = 0;
+    for (; idx + 16 <= len; idx += 16) {
+        __m512d lo = _mm512_fmadd_pd(factor, _mm512_loadu_pd(b + idx), _mm512_loadu_pd(out + idx));
+        __m512d hi = _mm512_fmadd_pd(factor, _mm512_loadu_pd(b + idx + 8), _mm512_loadu_pd(out + idx + 8));
+        _mm512_storeu_pd(out + idx, lo);
+        _mm512_storeu_pd(out + idx + 8, hi);
+    }
+    for (; idx + 8 <= len; idx += 8)
+        _mm512_storeu_pd(out + idx, _mm512_fmadd_pd(factor, _mm512_loadu_pd(b + idx), _mm512_loadu_pd(out + idx)));
+    if (idx < len) {
+        __mmask8 mask = tail_mask(len - idx);
+        __m512d sum = _mm512_fmadd_pd(factor, _mm512_maskz_loadu_pd(mask, b + idx), _mm512_maskz_loadu_pd(mask, out + idx));
+        _mm512_mask_storeu_pd(out + idx, mask, sum);
+    }
+}
+
+
+static void product(const double *a, const double *b, double *out, size_t m, size_t k, size_t n) {
+    blocked_product(a, b, out, m, k, n, row_axpy);
+}
+
+
+const SimdKernels avx512_kernels = {add, sub, scale, product};
@@ -0,0 +1,118 @@
+#include <cstdlib>
+#include <cstring>
+#include "simd.h"
+
+#ifdef LIBMATRIX_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+
+#ifdef LIBMATRIX_X86
+static void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4]) {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuidex(info, (int) leaf, (int) subleaf);
+    for (int idx = 0; idx < 4; idx++) regs[idx] = (unsigned int) info[idx];
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+
+// Register state the OS saves on context switch (XCR0).
+static unsigned long long xgetbv0() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long) edx << 32) | eax;
+#endif
+}
+#endif
+
+
+static SimdLevel detect_level() {
+#ifdef LIBMATRIX_X86
+    unsigned int regs[4];
+    cpuid(0, 0, regs);
+    unsigned int max_leaf = regs[0];
+
+    cpuid(1, 0, regs);
+    bool sse2 = regs[3] & (1u << 26);
+    bool fma = regs[2] & (1u << 12);
+    bool osxsave = regs[2] & (1u << 27);
+    bool avx = regs[2] & (1u << 28);
+    if (!sse2) return SIMD_SCALAR;
+    if (!osxsave || !avx || !fma || max_leaf < 7) return SIMD_SSE2;
+
+    unsigned long long xcr0 = xgetbv0();
+    if ((xcr0 & 0x6) != 0x6) return SIMD_SSE2;  // XMM and YMM state
+
+    cpuid(7, 0, regs);
+    bool avx2 = regs[1] & (1u << 5);
+    bool avx512f = regs[1] & (1u << 16);
+    if (!avx2) return SIMD_SSE2;
+    if (avx512f && (xcr0 & 0xe6) == 0xe6) return SIMD_AVX512;  // plus opmask and ZMM state
+    return SIMD_AVX2;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+
+static SimdLevel select_level() {
+    SimdLevel supported = detect_level();
+
+    const char *forced = std::getenv("LIBMATRIX_SIMD");
+    if (forced == nullptr) return supported;
+
+    SimdLevel level = supported;
+    if (strcmp(forced, "scalar") == 0) level = SIMD_SCALAR;
+    else if (strcmp(forced, "sse2") == 0) level = SIMD_SSE2;
+    else if (strcmp(forced, "avx2") == 0) level = SIMD_AVX2;
+    else if (strcmp(forced, "avx512") == 0) level = SIMD_AVX512;
+
+    return (level < supported) ? level : supported;
+}
+
+
+SimdLevel simd_level() {
+    static const SimdLevel level = select_level();
+    return level;
+}
+
+
+const char *simd_level_name(SimdLevel level) {
+    switch (level) {
+        case (SIMD_SSE2):
+            return "sse2";
+        case (SIMD_AVX2):
+            return "avx2";
+        case (SIMD_AVX512):
+            return "avx512";
+        default:
+            return "scalar";
+    }
+}
+
+
+const SimdKernels &simd_kernels() {
+#ifdef LIBMATRIX_X86
+    switch (simd_level()) {
+        case (SIMD_AVX512):
+            return avx512_kernels;
+        case (SIMD_AVX2):
+            return avx2_kernels;
+        case (SIMD_SSE2):
+            return sse2_kernels;
+        default:
+            break;
+    }
+#endif
+    return scalar_kernels;
+}
@@ -0,0 +1,29 @@
+#include "simd.h"
+
+
+static void add(const double *a, const double *b, double *out, size_t n) {
+    for (size_t idx = 0; idx < n; idx++) out[idx] = a[idx] + b[idx];
+}
+
+
+static void sub(const double *a, const double *b, double *out, size_t n) {
+    for (size_t idx = 0; idx < n; idx++) out[idx] = a[idx] - b[idx];
+}
+
+
+static void scale(const double *a, double scalar, double *out, size_t n) {
+    for (size_t idx = 0; idx < n; idx++) out[idx] = a[idx] * scalar;
+}
+
+
+static void row_axpy(double alpha, const double *b, double *out, size_t len) {
+    for (size_t idx = 0; idx < len; idx++) out[idx] += alpha * b[idx];
+}
+
+
+static void product(const double *a, const double *b, double *out, size_t m, size_t k, size_t n) {
+    blocked_product(a, b, out, m, k, n, row_axpy);
+}
+
+
+const SimdKernels scalar_kernels = {add, sub, scale, product};
@@ -0,0 +1,48 @@
+#include <emmintrin.h>
+#include "simd.h"
+
+
+static void add(const double *a, const double *b, double *out, size_t n) {
+    size_t idx = 0;
+    for (; idx + 2 <= n; idx += 2)
+        _mm_storeu_pd(out + idx, _mm_add_pd(_mm_loadu_pd(a + idx), _mm_loadu_pd(b + idx)));
+    for (; idx < n; idx++) out[idx] = a[idx] + b[idx];
+}
+
+
+static void sub(const double *a, const double *b, double *out, size_t n) {
+    size_t idx = 0;
+    for (; idx + 2 <= n; idx += 2)
+        _mm_storeu_pd(out + idx, _mm_sub_pd(_mm_loadu_pd(a + idx), _mm_loadu_pd(b + idx)));
+    for (; idx < n; idx++) out[idx] = a[idx] - b[idx];
+}
+
+
+static void scale(const double *a, double scalar, double *out, size_t n) {
+    __m128d factor = _mm_set1_pd(scalar);
+    size_t idx = 0;
+    for (; idx + 2 <= n; idx += 2)
+        _mm_storeu_pd(out + idx, _mm_mul_pd(_mm_loadu_pd(a + idx), factor));
+    for (; idx < n; idx++) out[idx] = a[idx] * scalar;
+}
+
+
+static void row_axpy(double alpha, const double *b, double *out, size_t len) {
+    __m128d factor = _mm_set1_pd(alpha);
+    size_t idx = 0;
+    for (; idx + 4 <= len; idx += 4) {
+        __m128d lo = _mm_add_pd(_mm_loadu_pd(out + idx), _mm_mul_pd(factor, _mm_loadu_pd(b + idx)));
+        __m128d hi = _mm_add_pd(_mm_loadu_pd(out + idx + 2), _mm_mul_pd(factor, _mm_loadu_pd(b + idx + 2)));
+        _mm_storeu_pd(out + idx, lo);
+        _mm_storeu_pd(out + idx + 2, hi);
+    }
+    for (; idx < len; idx++) out[idx] += alpha * b[idx];
+}
+
+
+static void product(const double *a, const double *b, double *out, size_t m, size_t k, size_t n) {
+    blocked_product(a, b, out, m, k, n, row_axpy);
+}
+
+
+const SimdKernels sse2_kernels = {add, sub, scale, product};
@@ -1,6 +1,236 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
 #include "libmatrix.h"
 
-int main() {
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#define setenv(name, value, overwrite) _putenv_s(name, value)
+#define unsetenv(name) _putenv_s(name, "")
+#endif
+
+
+// Deterministic entries, the same on every run
+Matrix sample(size_t rows, size_t cols, double seed) {
+    Matrix M = {rows, cols, UNFILLED};
+    for (size_t row = 0; row < rows; row++)
+        for (size_t col = 0; col < cols; col++)
+            M.set(row, col, std::sin(seed + 1.3 * row + 0.7 * col * col + 0.1 * row * col));
+    return M;
+}
+
+
+double max_abs_diff(Matrix &A, Matrix &B, size_t rows, size_t cols) {
+    double diff = 0.;
+    for (size_t row = 0; row < rows; row++)
+        for (size_t col = 0; col < cols; col++)
+            diff = std::max(diff, std::fabs(A.get(row, col) - B.get(row, col)));
+    return diff;
+}
+
+
+// Gaussian elimination with partial pivoting on a copy, the reference for any size
+double dense_det(Matrix &A, size_t n) {
+    std::vector<double> a(n * n);
+    for (size_t row = 0; row < n; row++)
+        for (size_t col = 0; col < n; col++) a[row * n + col] = A.get(row, col);
+
+    double det = 1.;
+    for (size_t k = 0; k < n; k++) {
+        size_t pivot = k;
+        for (size_t row = k + 1; row < n; row++)
+            if (std::fabs(a[row * n + k]) > std::fabs(a[pivot * n + k])) pivot = row;
+        if (a[pivot * n + k] == 0.) return 0.;
+        if (pivot != k) {
+            for (size_t col = 0; col < n; col++) std::swap(a[k * n + col], a[pivot * n + col]);
+            det = -det;
+        }
+        det *= a[k * n + k];
+        for (size_t row = k + 1; row < n; row++) {
+            double factor = a[row * n + k] / a[k * n + k];
+            for (size_t col = k; col < n; col++) a[row * n + col] -= factor * a[k * n + col];
+        }
+    }
+    return det;
+}
+
+
+bool check(const char *name, bool ok) {
+    std::cout << name << ": " << (ok ? "OK" : "FAILED") << std::endl;
+    return ok;
+}
+
+
+// Band LU against dense elimination, with small diagonals so rows get swapped
+bool check_banded() {
+    const size_t n = 50, k = 3;
+    const size_t bands[][2] = {{3, 2}, {1, 1}, {0, 4}, {5, 0}};
+    bool ok = true;
+
+    for (const auto &band : bands) {
+        size_t kl = band[0], ku = band[1];
+        BandedMatrix B{n, kl, ku};
+        for (size_t row = 0; row < n; row++)
+            for (size_t col = (row > kl) ? row - kl : 0; col <= std::min(n - 1, row + ku); col++)
+                B.set(row, col, (row != col) ? std::sin(0.9 * row + 1.7 * col + kl)
+                                : (kl > 0 && ku > 0) ? 0.1 * std::sin(2.6 * row) : 2. + std::sin(row));
+
+        Matrix D = B.to_dense();
+        double det = dense_det(D, n);
+        ok = ok && std::fabs(B.det() - det) <= 1e-9 * std::fabs(det);
+
+        Matrix R = sample(n, k, 0.5);
+        Matrix X = B.solve(R);
+        Matrix BX = B * X;
+        ok = ok && max_abs_diff(BX, R, n, k) < 1e-9;
+
+        Matrix M = sample(n, k, 2.);
+        Matrix BM = B * M;
+        Matrix DM = D * M;
+        ok = ok && max_abs_diff(BM, DM, n, k) < 1e-12;
+    }
+
+    BandedMatrix T{n, 1, 1};
+    for (size_t row = 0; row < n; row++) {
+        T.set(row, row, 4. + std::sin(row));
+        if (row > 0) T.set(row, row - 1, std::cos(row));
+        if (row + 1 < n) T.set(row, row + 1, -1.);
+    }
+    Matrix R = sample(n, k, 1.);
+    Matrix X = T.solve_tridiagonal(R);
+    Matrix TX = T * X;
+    Matrix Y = T.solve(R);
+    ok = ok && max_abs_diff(TX, R, n, k) < 1e-12 && max_abs_diff(X, Y, n, k) < 1e-12;
+
+    return check("BandedMatrix det, solve, solve_tridiagonal and product", ok);
+}
+
+
+// Normal equations A^T * (A * X - B) = 0 hold for the least-squares X
+double normal_residual(Matrix &A, Matrix &X, Matrix &B, size_t m, size_t n, size_t k) {
+    Matrix AX = A * X;
+    double residual = 0.;
+    for (size_t col = 0; col < n; col++)
+        for (size_t rhs = 0; rhs < k; rhs++) {
+            double sum = 0.;
+            for (size_t row = 0; row < m; row++) sum += A.get(row, col) * (AX.get(row, rhs) - B.get(row, rhs));
+            residual = std::max(residual, std::fabs(sum));
+        }
+    return residual;
+}
+
+
+// Blocked QR and TSQR around the QR_BLOCK = 32 boundary, with several
+// streaming chunks, and with fewer rows than n + k so TSQR has one thread
+bool check_least_squares() {
+    const size_t shapes[][3] = {{200, 31, 2}, {200, 32, 3}, {300, 33, 1}, {1000, 32, 3}, {40, 33, 10}, {33, 33, 1}};
+    const size_t thread_counts[] = {1, 2, 3, 4, 7};
+    bool ok = true;
+
+    for (const auto &shape : shapes) {
+        size_t m = shape[0], n = shape[1], k = shape[2];
+        Matrix A = sample(m, n, 0.3);
+        Matrix B = sample(m, k, 1.9);
+        for (size_t idx = 0; idx < n; idx++) A.set(idx, idx, A.get(idx, idx) + 4.);  // well conditioned
+
+        Matrix X = solve_least_squares(A, B);
+        ok = ok && normal_residual(A, X, B, m, n, k) < 1e-9 * m;
+
+        for (size_t threads : thread_counts) {
+            Matrix Y = solve_least_squares_tsqr(A, B, threads);
+            ok = ok && max_abs_diff(X, Y, n, k) < 1e-9;
+        }
+
+        // R^T * R = A^T * A
+        HouseholderQR qr(A);
+        Matrix R = qr.R();
+        for (size_t row = 0; row < n; row++)
+            for (size_t col = 0; col < n; col++) {
+                double rr = 0., aa = 0.;
+                for (size_t idx = 0; idx < n; idx++) rr += R.get(idx, row) * R.get(idx, col);
+                for (size_t idx = 0; idx < m; idx++) aa += A.get(idx, row) * A.get(idx, col);
+                ok = ok && std::fabs(rr - aa) < 1e-10 * m;
+            }
+    }
+
+    return check("HouseholderQR and TSQR least squares", ok);
+}
+
+
+// Sums, differences, scalings and products with tails after every vector
+// width and more than one SIMD_BLOCK_K / SIMD_BLOCK_N block, printed in full
+void print_simd_sample() {
+    const size_t m = 37, k = 131, n = 517;
+    Matrix A = sample(m, k, 0.2);
+    Matrix B = sample(m, k, 2.4);
+    Matrix C = sample(k, n, 1.1);
+
+    Matrix results[] = {A + B, A - B, A * 0.75, A * C};
+    const size_t cols[] = {k, k, k, n};
+
+    std::printf("%s\n", matrix_simd_level());
+    for (size_t idx = 0; idx < 4; idx++)
+        for (size_t row = 0; row < m; row++)
+            for (size_t col = 0; col < cols[idx]; col++) std::printf("%.17g\n", results[idx].get(row, col));
+}
+
+
+// The level is picked once per process, so every forced level is a fresh run
+// of this program; levels the CPU lacks fall back and are skipped
+bool check_simd_levels(const char *program) {
+    const char *levels[] = {"scalar", "sse2", "avx2", "avx512"};
+    std::vector<double> reference;
+    bool ok = true;
+
+    for (const char *level : levels) {
+        setenv("LIBMATRIX_SIMD", level, 1);
+        std::string command = std::string("\"") + program + "\" --simd-sample";
+        FILE *child = popen(command.c_str(), "r");
+        if (child == nullptr) return check("SIMD levels", false);
+
+        char used[16] = {0};
+        std::vector<double> values;
+        double value;
+        if (std::fscanf(child, "%15s", used) == 1)
+            while (std::fscanf(child, "%lf", &value) == 1) values.push_back(value);
+        pclose(child);
+
+        if (std::string(used) != level) {
+            std::cout << "SIMD level " << level << ": not supported, skipped" << std::endl;
+            continue;
+        }
+
+        if (reference.empty()) {
+            reference = values;
+            if (values.empty()) return check("SIMD level scalar", false);
+            continue;
+        }
+
+        // Products may differ in rounding where FMA is used, by far less than this
+        bool same = !values.empty() && values.size() == reference.size();
+        for (size_t idx = 0; same && idx < values.size(); idx++)
+            same = std::fabs(values[idx] - reference[idx]) < 1e-12;
+
+        std::string name = std::string("SIMD level ") + level + " against scalar";
+        ok = check(name.c_str(), same) && ok;
+    }
+
+    unsetenv("LIBMATRIX_SIMD");
+    return ok;
+}
+
+
+int main(int argc, char **argv) {
+    if (argc > 1 && std::string(argv[1]) == "--simd-sample") {
+        print_simd_sample();
+        return 0;
+    }
+
+    std::cout << "SIMD level: " << matrix_simd_level() << std::endl;
+
     Matrix A = {3, 3, RANDOM};
     Matrix B = {3, 3, IDENTITY};
     Matrix C = {3, 3, IDENTITY};
@@ -26,5 +256,9 @@ int main() {
 
     B.print();
 
-    return 0;
+    bool ok = check_banded();
+    ok = check_least_squares() && ok;
+    ok = check_simd_levels(argv[0]) && ok;
+
+    return ok ? 0 : 1;
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
+#include <utility>
 
 class Matrix_Exception : public std::domain_error
 {
@@ -16,6 +17,8 @@ private:
     size_t rows;
     double* value;
 
+    static void square_product(const double* a, const double* b, double* c, size_t size);
+
 public:
     Matrix();
     Matrix(size_t col, size_t row);
@@ -31,7 +34,7 @@ public:
     Matrix& operator*(double number) const;
     Matrix& operator=(Matrix& matrix);
     Matrix& operator=(Matrix&& matrix);
-    Matrix& operator^(size_t number) const;
+    Matrix operator^(size_t number) const;
     Matrix& operator/(const double number) const;
     Matrix& exp(const size_t accuracy);
     Matrix& minor(Matrix& matrix1);
@@ -187,25 +190,54 @@ Matrix& Matrix::operator= (Matrix&& matrix) {
 }
 
 
-Matrix& Matrix::operator^ (size_t number) const {
+void Matrix::square_product(const double* a, const double* b, double* c, size_t size) {
+    for (size_t row = 0; row < size; row++) {
+        double* c_row = c + row * size;
+        for (size_t col = 0; col < size; col++) {
+            c_row[col] = 0.00;
+        }
+        for (size_t k = 0; k < size; k++) {
+            const double factor = a[row * size + k];
+            const double* b_row = b + k * size;
+            for (size_t col = 0; col < size; col++) {
+                c_row[col] += factor * b_row[col];
+            }
+        }
+    }
+}
+
+
+Matrix Matrix::operator^ (size_t number) const {
     if (cols != rows) throw ("Make matrix square\n");
-    Matrix *result = new Matrix(*this);
+    Matrix result(rows, cols);
+    result.set_one();
 
     if (number == 0) {
-        result->set_one();
-        return *result;
-    }
-
-    if (number == 1) {
-        return *result;
+        return result;
     }
 
-    const Matrix& start(*result);
+    // Exponentiation by squaring, base and result swap buffers with scratch
+    Matrix base(*this);
+    Matrix scratch(rows, cols);
+    bool started = false;
 
-    for (size_t idx = 0; idx < number; idx++) {
-        *result = *result * *this;
+    while (true) {
+        if (number & 1) {
+            if (started) {
+                square_product(result.value, base.value, scratch.value, rows);
+                std::swap(result.value, scratch.value);
+            }
+            else {
+                memcpy(result.value, base.value, rows * cols * sizeof(double));
+                started = true;
+            }
+        }
+        number >>= 1;
+        if (number == 0) break;
+        square_product(base.value, base.value, scratch.value, rows);
+        std::swap(base.value, scratch.value);
     }
-    return *result;
+    return result;
 }
 
 
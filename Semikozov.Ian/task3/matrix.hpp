@@ -6,6 +6,9 @@
 #include <iostream>
 #include <random>
 #include <iomanip>
+#include <new>
+#include <algorithm>
+#include <type_traits>
 #include <stdint.h>
 
 namespace Matrix 
@@ -18,9 +21,31 @@ namespace Matrix
         Random_Matrix
     };
 
+    // Contiguous view of one matrix row
+    template <typename Matrix_Item>
+    class Row_Span
+    {
+    private:
+        Matrix_Item *m_begin;
+        size_t m_size;
+    public:
+        Row_Span(Matrix_Item *begin, size_t size) : m_begin(begin), m_size(size) {}
+
+        Matrix_Item *begin() const { return m_begin; }
+        Matrix_Item *end() const { return m_begin + m_size; }
+        Matrix_Item *data() const { return m_begin; }
+        size_t size() const { return m_size; }
+        Matrix_Item &operator[](size_t idx) const { return m_begin[idx]; }
+    };
+
     template <typename Matrix_Item>
     class Matrix
     {
+        static_assert(std::is_trivially_copyable<Matrix_Item>::value,
+                      "Matrix storage is handled with raw memory operations");
+    public:
+        // Every row starts on a cache line, so rows can be loaded with aligned vector loads
+        static constexpr size_t alignment = 64;
     private:
         class Matrix_Exception : public std::exception {
         private:
@@ -36,8 +61,34 @@ namespace Matrix
 
         size_t m_rows{0};
         size_t m_cols{0};
+        size_t m_stride{0};
         Matrix_Type m_type;
-        Matrix_Item **m_data{nullptr};
+        Matrix_Item *m_data{nullptr};
+
+        static size_t padded_stride(size_t cols)
+        {
+            const size_t per_line = alignment / sizeof(Matrix_Item);
+            if (per_line == 0 || alignment % sizeof(Matrix_Item) != 0) {
+                return cols;
+            }
+            return (cols + per_line - 1) / per_line * per_line;
+        }
+
+        void allocate()
+        {
+            m_stride = padded_stride(m_cols);
+            m_data = static_cast<Matrix_Item *>(
+                ::operator new(m_rows * m_stride * sizeof(Matrix_Item), std::align_val_t{alignment}));
+        }
+
+        void release()
+        {
+            if (m_data != nullptr) {
+                ::operator delete(m_data, std::align_val_t{alignment});
+            }
+            m_data = nullptr;
+        }
+
     public:
         Matrix(size_t rows, size_t cols) : m_rows(rows), m_cols(cols), m_type(Matrix_Type::Zero_Matrix)
         {
@@ -45,75 +96,91 @@ namespace Matrix
             {   
                 throw Matrix_Exception("Bad arguments passed to the constructor");
             }
-            m_data = new Matrix_Item*[rows];
-            for (int i = 0; i < rows; ++i) 
-            {
-                m_data[i] = new Matrix_Item[cols];
-            }
+            allocate();
+            fill_matrix(m_type);
         }
 
         Matrix(size_t rows, size_t cols, Matrix_Type type) : m_rows(rows), m_cols(cols), m_type(type)
         {
-            m_data = new Matrix_Item*[rows];
-            for (int i = 0; i < rows; ++i) {
-                m_data[i] = new Matrix_Item[cols];
-            }
+            allocate();
             fill_matrix(type);
         }
 
         Matrix(const Matrix& other) : m_rows(other.m_rows), m_cols(other.m_cols), m_type(other.m_type) 
         {
-            m_data = new int*[m_rows];
-            for (int i = 0; i < m_rows; ++i) {
-                m_data[i] = new int[m_cols];
-                for (int j = 0; j < m_cols; ++j) {
-                    m_data[i][j] = other.m_data[i][j];
-                }
-            }
+            allocate();
+            std::memcpy(m_data, other.m_data, m_rows * m_stride * sizeof(Matrix_Item));
+        }
+
+        Matrix(Matrix&& other) noexcept
+            : m_rows(other.m_rows), m_cols(other.m_cols), m_stride(other.m_stride),
+              m_type(other.m_type), m_data(other.m_data)
+        {
+            other.m_rows = 0;
+            other.m_cols = 0;
+            other.m_stride = 0;
+            other.m_data = nullptr;
         }
 
         ~Matrix() 
         {
-            for (int i = 0; i < m_rows; ++i) {
-                delete[] m_data[i];
-            }
-            delete[] m_data;
+            release();
         }
         
         friend std::ostream& operator<<(std::ostream& os, const Matrix& matrix) 
         {
-            for (int i = 0; i < matrix.m_rows; ++i) {
-                for (int j = 0; j < matrix.m_cols; ++j) {
-                    os << matrix.m_data[i][j] << " ";
+            for (size_t i = 0; i < matrix.m_rows; ++i) {
+                for (size_t j = 0; j < matrix.m_cols; ++j) {
+                    os << matrix(i, j) << " ";
                 }
                 os << std::endl;
             }
             return os;
         }
 
-        Matrix_Item &operator()(int rows, int cols) 
+        Matrix_Item &operator()(size_t row, size_t col) 
         { 
-            return m_data[rows][cols];
+            return m_data[row * m_stride + col];
         }
+
+        const Matrix_Item &operator()(size_t row, size_t col) const
+        { 
+            return m_data[row * m_stride + col];
+        }
+
+        size_t rows() const { return m_rows; }
+        size_t cols() const { return m_cols; }
+        // Distance between the starts of two rows, in items
+        size_t stride() const { return m_stride; }
+
+        Row_Span<Matrix_Item> row(size_t row) 
+        {
+            return Row_Span<Matrix_Item>(m_data + row * m_stride, m_cols);
+        }
+
+        Row_Span<const Matrix_Item> row(size_t row) const
+        {
+            return Row_Span<const Matrix_Item>(m_data + row * m_stride, m_cols);
+        }
+
+        Matrix_Item *data() { return m_data; }
+        const Matrix_Item *data() const { return m_data; }
         
         Matrix &operator=(const Matrix &M) 
         {
             if (this != &M) {
-                for (int i = 0; i < m_rows; ++i) {
-                    delete[] m_data[i];
+                if (m_rows * padded_stride(m_cols) != M.m_rows * M.m_stride) {
+                    release();
+                    m_rows = M.m_rows;
+                    m_cols = M.m_cols;
+                    allocate();
                 }
-                delete[] m_data;
 
-                // new matrix allocation
                 m_rows = M.m_rows;
                 m_cols = M.m_cols;
-                m_data = new int*[m_rows];
-                for (int i = 0; i < m_rows; ++i) {
-                    m_data[i] = new int[m_cols];
-                    for (int j = 0; j < m_cols; ++j) {
-                        m_data[i][j] = M.m_data[i][j];
-                    }
-                }
+                m_stride = M.m_stride;
+                m_type = M.m_type;
+                std::memcpy(m_data, M.m_data, m_rows * m_stride * sizeof(Matrix_Item));
             }
             return *this;
         }
@@ -122,24 +189,33 @@ namespace Matrix
         {
             if (this != &M) 
             {
-                for (int i = 0; i < m_rows; ++i) 
-                {
-                    delete[] m_data[i];
-                }
-                delete[] m_data;
+                release();
                 
                 m_rows = M.m_rows;
                 m_cols = M.m_cols;
+                m_stride = M.m_stride;
+                m_type = M.m_type;
                 m_data = M.m_data;
+
+                M.m_rows = 0;
+                M.m_cols = 0;
+                M.m_stride = 0;
+                M.m_data = nullptr;
             }
             return *this;
         }
         Matrix operator+(const Matrix &M) const
         {
-            Matrix result(this);
-            for (int i = 0; i < m_rows; ++i) {
-                for (int j = 0; j < m_cols; ++j) {
-                    result.m_data[i][j] = m_data[i][j] + M.m_data[i][j];
+            if (m_rows != M.m_rows || m_cols != M.m_cols) {
+                throw Matrix_Exception("Matrix dimensions do not match");
+            }
+            Matrix result(m_rows, m_cols);
+            for (size_t i = 0; i < m_rows; ++i) {
+                const Matrix_Item *lhs = m_data + i * m_stride;
+                const Matrix_Item *rhs = M.m_data + i * M.m_stride;
+                Matrix_Item *out = result.m_data + i * result.m_stride;
+                for (size_t j = 0; j < m_cols; ++j) {
+                    out[j] = lhs[j] + rhs[j];
                 }
             }
             return result;
@@ -160,20 +236,20 @@ namespace Matrix
 
             switch (type) {
                 case (Matrix_Type::Zero_Matrix):
-                    std::memset(m_data, 0, m_cols * m_rows * sizeof(Matrix_Item));
+                    std::memset(m_data, 0, m_rows * m_stride * sizeof(Matrix_Item));
                     break;
                 case (Matrix_Type::Ones_Matrix):
-                    std::memset(m_data, 1, m_cols * m_rows * sizeof(Matrix_Item));
+                    for (size_t i = 0; i < m_rows; ++i) {
+                        std::fill(m_data + i * m_stride, m_data + i * m_stride + m_cols, Matrix_Item(1));
+                    }
                     break;
                 case (Matrix_Type::Identity_Matrix):
-                    if (m_cols == m_cols) 
+                    if (m_rows == m_cols) 
                     {
-                        for (int i = 0; i < m_rows; i++) 
+                        std::memset(m_data, 0, m_rows * m_stride * sizeof(Matrix_Item));
+                        for (size_t i = 0; i < m_rows; i++) 
                         {
-                            for (int j = 0; j < m_cols; j++) 
-                            {
-                                m_data[i][j] = (i == j) ? 1. : 0.;
-                            }
+                            m_data[i * m_stride + i] = Matrix_Item(1);
                         }
                     } 
                     else 
@@ -190,9 +266,10 @@ namespace Matrix
         void random()
         {
             srand(static_cast<unsigned>(time(nullptr)));
-            for (int i = 0; i < m_rows; ++i) {
-                for (int j = 0; j < m_cols; ++j) {
-                    m_data[i][j] = rand() % 100;
+            for (size_t i = 0; i < m_rows; ++i) {
+                Matrix_Item *row = m_data + i * m_stride;
+                for (size_t j = 0; j < m_cols; ++j) {
+                    row[j] = rand() % 100;
                 }
             }
         }
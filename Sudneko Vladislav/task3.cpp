@@ -1,5 +1,9 @@
+#include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 const double PRECISION = 10e-8;  // computation precision
 using namespace std;
@@ -79,6 +83,45 @@ public:
         rows = 0;
         delete[] this->cells;
     }
+
+    bool is_symmetric() const;
+
+    friend class Cholesky;
+};
+
+// 10. Factorization of symmetric matrices, computed once and reused.
+// A = L * L^T for positive definite input (blocked, right-looking, with the
+// trailing update split between threads). When a pivot is not positive it
+// falls back to P * A * P^T = L * D * L^T with Bunch-Kaufman pivoting, D made
+// of 1x1 and 2x2 blocks, which handles any symmetric input, singular or not.
+class Cholesky {
+private:
+    size_t n;
+    Matrix factor;  // L below the diagonal; its diagonal (Cholesky) or D (LDL^T)
+    vector<size_t> permutation;  // LDL^T only: row k of P * A is row permutation[k] of A
+    vector<size_t> block;        // LDL^T only: 2 at the first row of a 2x2 block of D, else 1
+    bool pivoted;
+    size_t rank;
+
+    bool factor_blocked();
+    void factor_ldlt(const Matrix& A);
+    double block_det(size_t k) const;
+    void solve_in_place(double* x, size_t nrhs) const;
+
+public:
+    explicit Cholesky(const Matrix& A);
+
+    // False for semidefinite input too: only set when L * L^T went through
+    bool is_positive_definite() const { return !pivoted; }
+    // n minus the numerically zero pivots of D
+    size_t get_rank() const { return rank; }
+
+    double det() const;
+    double logdet() const;  // log |det|, -inf when singular
+    // Zero pivots of a semidefinite matrix are skipped, giving a solution
+    // whenever B lies in the range of A
+    Matrix solve(const Matrix& B) const;
+    Matrix inverse() const;
 };
 
 class MatrixException : public std::exception {
@@ -93,6 +136,7 @@ MatrixException SHAPE_ERROR(
 MatrixException MEMORY_ERROR("\nError: memory are not allocated\n\n");
 MatrixException INDEX_ERROR(
     "\nError: one of the indexes is bigger than matrix size\n\n");
+MatrixException SINGULAR_ERROR("\nError: matrix is singular\n\n");
 
 void function_testing() {
     // Create
@@ -141,6 +185,52 @@ void function_testing() {
     C = A.exp();
     cout << "EXPONENT OF MATRIX A:" << endl;
     C.print();
+
+    Matrix I = Matrix(3, 3).fill_identity();
+    Matrix S = A * A.T() + I;
+    Cholesky chol(S);
+    cout << "CHOLESKY OF A * A^T + I, DETERMINANT AND LOG-DETERMINANT:" << endl;
+    cout << chol.det() << " " << chol.logdet() << endl << endl;
+    C = S * chol.inverse();
+    cout << "(A * A^T + I) * INVERSE:" << endl;
+    C.print();
+
+    // Zero diagonal: only the 2x2 pivots of D get through these
+    double swap_cells[] = {0, 1, 1, 0};
+    double indefinite_cells[] = {0, 1, 2, 1, 0, 3, 2, 3, 0};
+    Matrix P = Matrix(2, 2).fill_from_array(swap_cells);
+    Matrix Q = Matrix(3, 3).fill_from_array(indefinite_cells);
+    Cholesky ldlt(Q);
+    C = Q * ldlt.inverse() - Matrix(3, 3).fill_identity();
+    double residual = 0.0;
+    for (size_t row = 0; row < 3; row++)
+        for (size_t column = 0; column < 3; column++)
+            residual = max(residual, fabs(C.get(row, column)));
+    bool passed = fabs(P.det() + 1.0) < PRECISION && fabs(Q.det() - 12.0) < PRECISION &&
+                  !ldlt.is_positive_definite() && ldlt.get_rank() == 3 &&
+                  fabs(ldlt.logdet() - log(12.0)) < PRECISION && residual < PRECISION;
+    cout << "ZERO DIAGONAL INDEFINITE DETERMINANTS (-1 AND 12) AND INVERSE:" << endl;
+    cout << P.det() << " " << Q.det() << (passed ? " PASSED" : " FAILED") << endl << endl;
+
+    // Several CHOLESKY_BLOCK panels and a partial one, through the blocked path
+    const size_t n = 200;
+    Matrix R = Matrix(n, n).fill_random(1, 10);
+    Matrix big = R * R.T() + Matrix(n, n).fill_identity() * double(n);
+    Matrix rhs = Matrix(n, 3).fill_random(1, 10);
+    Cholesky big_chol(big);
+    Matrix big_identity = big * big_chol.inverse() - Matrix(n, n).fill_identity();
+    Matrix big_residual = big * big_chol.solve(rhs) - rhs;
+    double inverse_error = 0.0, solve_error = 0.0;
+    for (size_t row = 0; row < n; row++) {
+        for (size_t column = 0; column < n; column++)
+            inverse_error = max(inverse_error, fabs(big_identity.get(row, column)));
+        for (size_t column = 0; column < 3; column++)
+            solve_error = max(solve_error, fabs(big_residual.get(row, column)));
+    }
+    passed = big_chol.is_positive_definite() && big_chol.get_rank() == n &&
+             inverse_error < PRECISION && solve_error < PRECISION;
+    cout << "BLOCKED CHOLESKY OF A 200 x 200 R * R^T + 200 * I, INVERSE AND SOLVE:" << endl;
+    cout << inverse_error << " " << solve_error << (passed ? " PASSED" : " FAILED") << endl << endl;
 }
 
 int main() {
@@ -315,7 +405,7 @@ Matrix Matrix::operator/(const double value) const {
 Matrix Matrix::operator*(const Matrix& other_matrix) const {
     if (this->columns != other_matrix.rows) throw SHAPE_ERROR;
 
-    Matrix result = { this->rows, this->columns };
+    Matrix result = { this->rows, other_matrix.columns };
 
     for (size_t row = 0; row < result.rows; row++) {
         for (size_t column = 0; column < result.columns; column++) {
@@ -349,6 +439,9 @@ Matrix Matrix::T() const {
 double Matrix::det() const {
     if (rows != columns) throw SQUARE_ERROR;
 
+    // Symmetric input: Cholesky does a third of the work of elimination
+    if (is_symmetric()) return Cholesky(*this).det();
+
     Matrix triangular_matrix = { this->rows, this->columns };
     triangular_matrix = *this;
 
@@ -399,4 +492,320 @@ Matrix Matrix::exp() const {
         result += current_element;
     }
     return result;
-}
\ No newline at end of file
+}
+
+bool Matrix::is_symmetric() const {
+    if (rows != columns) return false;
+
+    for (size_t row = 0; row < rows; row++)
+        for (size_t column = 0; column < row; column++)
+            if (cells[row * columns + column] != cells[column * columns + row])
+                return false;
+
+    return true;
+}
+
+// 10. Factorization of symmetric matrices
+
+const size_t CHOLESKY_BLOCK = 64;       // columns factored per step
+const size_t PARALLEL_WORK = 1 << 18;   // multiply-adds worth one more thread
+
+// Runs body(first, last) over rows [begin, end) in threads of equal work:
+// every row costs depth, or (i - begin + 1) * depth for a lower triangle.
+template <typename Body>
+void parallel_rows(size_t begin, size_t end, size_t depth, bool triangle, Body body) {
+    size_t count = end - begin;
+    size_t work = (triangle ? count * (count + 1) / 2 : count) * depth;
+    size_t threads = min<size_t>(max(1u, thread::hardware_concurrency()),
+                                 work / PARALLEL_WORK + 1);
+    threads = min(threads, max<size_t>(count, 1));
+
+    if (threads <= 1) {
+        body(begin, end);
+        return;
+    }
+
+    vector<thread> workers;
+    size_t first = begin;
+    for (size_t part = 1; part <= threads; part++) {
+        // a triangle's area up to row r grows as r^2
+        double share = (double)part / threads;
+        size_t last = (part == threads)
+            ? end
+            : begin + (size_t)(count * (triangle ? sqrt(share) : share));
+        last = max(last, first);
+        if (part == threads) body(first, last);
+        else workers.emplace_back(body, first, last);
+        first = last;
+    }
+    for (thread& worker : workers) worker.join();
+}
+
+Cholesky::Cholesky(const Matrix& A)
+    : n(A.rows), factor(A), pivoted(false), rank(A.rows) {
+    if (A.rows != A.columns) throw SQUARE_ERROR;
+
+    if (!factor_blocked()) factor_ldlt(A);
+}
+
+// Right-looking: factor a diagonal block, solve the panel under it, then
+// subtract the panel's outer product from the lower trailing triangle.
+// Only the lower triangle of factor is read. Returns false on a
+// non-positive pivot.
+bool Cholesky::factor_blocked() {
+    double* a = factor.cells;
+
+    for (size_t k0 = 0; k0 < n; k0 += CHOLESKY_BLOCK) {
+        size_t k1 = min(n, k0 + CHOLESKY_BLOCK);
+
+        for (size_t j = k0; j < k1; j++) {
+            double* row_j = a + j * n;
+            double diag = row_j[j];
+            for (size_t p = k0; p < j; p++) diag -= row_j[p] * row_j[p];
+            if (!(diag > 0.0)) return false;
+            row_j[j] = sqrt(diag);
+
+            for (size_t i = j + 1; i < k1; i++) {
+                double* row_i = a + i * n;
+                double sum = row_i[j];
+                for (size_t p = k0; p < j; p++) sum -= row_i[p] * row_j[p];
+                row_i[j] = sum / row_j[j];
+            }
+        }
+
+        if (k1 == n) break;
+
+        // L21 = A21 * L11^-T and A22 -= L21 * L21^T, rows are independent
+        parallel_rows(k1, n, (k1 - k0) * (k1 - k0) / 2, false, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; i++) {
+                double* row_i = a + i * n;
+                for (size_t j = k0; j < k1; j++) {
+                    const double* row_j = a + j * n;
+                    double sum = row_i[j];
+                    for (size_t p = k0; p < j; p++) sum -= row_i[p] * row_j[p];
+                    row_i[j] = sum / row_j[j];
+                }
+            }
+        });
+        parallel_rows(k1, n, k1 - k0, true, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; i++) {
+                double* row_i = a + i * n;
+                for (size_t j = k1; j <= i; j++) {
+                    const double* row_j = a + j * n;
+                    double sum = 0.0;
+                    for (size_t p = k0; p < k1; p++) sum += row_i[p] * row_j[p];
+                    row_i[j] -= sum;
+                }
+            }
+        });
+    }
+
+    return true;
+}
+
+// Unblocked Bunch-Kaufman LDL^T on a full copy of A, as LAPACK's dsytf2: a
+// diagonal too small next to its column is paired with the row holding the
+// column's largest entry into a 2x2 block of D, so a zero diagonal does not
+// stop it. Rows and columns are swapped together so the trailing part stays
+// symmetric; the off-diagonal of a 2x2 block is kept where L would be.
+void Cholesky::factor_ldlt(const Matrix& A) {
+    factor = A;
+    pivoted = true;
+    permutation.resize(n);
+    for (size_t k = 0; k < n; k++) permutation[k] = k;
+    block.assign(n, 1);
+
+    double* a = factor.cells;
+    double largest = 0.0;
+    for (size_t k = 0; k < n * n; k++) largest = max(largest, fabs(a[k]));
+    double tolerance = n * 2.2e-16 * largest;
+    const double alpha = (1.0 + sqrt(17.0)) / 8.0;  // bounds the growth of L
+
+    rank = n;
+    for (size_t k = 0; k < n;) {
+        double diag = fabs(a[k * n + k]);
+        double column = 0.0;
+        size_t row = k;
+        for (size_t i = k + 1; i < n; i++)
+            if (fabs(a[i * n + k]) > column) {
+                column = fabs(a[i * n + k]);
+                row = i;
+            }
+
+        if (max(diag, column) <= tolerance) {
+            // column k is numerically zero: D_kk = 0 and L's column is e_k
+            for (size_t i = k; i < n; i++) a[i * n + k] = a[k * n + i] = 0.0;
+            rank--;
+            k++;
+            continue;
+        }
+
+        size_t step = 1, pivot = k;
+        if (diag < alpha * column) {
+            double row_max = 0.0;
+            for (size_t j = k; j < n; j++)
+                if (j != row) row_max = max(row_max, fabs(a[row * n + j]));
+
+            if (diag * row_max >= alpha * column * column) pivot = k;
+            else if (fabs(a[row * n + row]) >= alpha * row_max) pivot = row;
+            else {
+                pivot = row;
+                step = 2;
+            }
+        }
+
+        size_t last = k + step - 1;
+        if (pivot != last) {
+            swap_ranges(a + last * n, a + (last + 1) * n, a + pivot * n);
+            for (size_t i = 0; i < n; i++) swap(a[i * n + last], a[i * n + pivot]);
+            swap(permutation[last], permutation[pivot]);
+        }
+
+        if (step == 1) {
+            double d = a[k * n + k];
+            for (size_t i = k + 1; i < n; i++) {
+                double* row_i = a + i * n;
+                double l_ik = row_i[k] / d;
+                for (size_t j = k + 1; j <= i; j++) {
+                    row_i[j] -= l_ik * a[j * n + k];
+                    a[j * n + i] = row_i[j];
+                }
+            }
+            for (size_t i = k + 1; i < n; i++) a[i * n + k] /= d;
+        } else {
+            // [l_ik l_ik+1] = [a_ik a_ik+1] * D^-1 with D = [d11 d21; d21 d22]
+            double d11 = a[k * n + k];
+            double d21 = a[(k + 1) * n + k];
+            double d22 = a[(k + 1) * n + k + 1];
+            double det = d11 * d22 - d21 * d21;
+            for (size_t i = k + 2; i < n; i++) {
+                double* row_i = a + i * n;
+                double l_ik = (row_i[k] * d22 - row_i[k + 1] * d21) / det;
+                double l_ik1 = (row_i[k + 1] * d11 - row_i[k] * d21) / det;
+                for (size_t j = k + 2; j <= i; j++) {
+                    row_i[j] -= l_ik * a[j * n + k] + l_ik1 * a[j * n + k + 1];
+                    a[j * n + i] = row_i[j];
+                }
+            }
+            for (size_t i = k + 2; i < n; i++) {
+                double* row_i = a + i * n;
+                double a_ik = row_i[k];
+                row_i[k] = (a_ik * d22 - row_i[k + 1] * d21) / det;
+                row_i[k + 1] = (row_i[k + 1] * d11 - a_ik * d21) / det;
+            }
+            block[k] = 2;
+        }
+        k += step;
+    }
+}
+
+// Determinant of the diagonal block of D (or of L's diagonal) starting at k
+double Cholesky::block_det(size_t k) const {
+    const double* l = factor.cells;
+    if (!pivoted) return l[k * n + k] * l[k * n + k];
+    if (block[k] == 1) return l[k * n + k];
+    return l[k * n + k] * l[(k + 1) * n + k + 1] - l[(k + 1) * n + k] * l[(k + 1) * n + k];
+}
+
+// x (n x nrhs, row-major) is overwritten with A^-1 x
+void Cholesky::solve_in_place(double* x, size_t nrhs) const {
+    const double* l = factor.cells;
+
+    if (pivoted) {
+        vector<double> permuted(n * nrhs);
+        for (size_t k = 0; k < n; k++)
+            memcpy(&permuted[k * nrhs], x + permutation[k] * nrhs, nrhs * sizeof(double));
+        memcpy(x, permuted.data(), n * nrhs * sizeof(double));
+    }
+
+    // the entry under a 2x2 block of D belongs to D, L is zero there
+    auto in_d = [&](size_t i, size_t j) {
+        return pivoted && j + 1 == i && block[j] == 2;
+    };
+
+    // L y = b; the diagonal is L's own for Cholesky and 1 for LDL^T
+    for (size_t i = 0; i < n; i++) {
+        double* x_i = x + i * nrhs;
+        for (size_t j = 0; j < i; j++) {
+            if (in_d(i, j)) continue;
+            double l_ij = l[i * n + j];
+            const double* x_j = x + j * nrhs;
+            for (size_t r = 0; r < nrhs; r++) x_i[r] -= l_ij * x_j[r];
+        }
+        if (!pivoted)
+            for (size_t r = 0; r < nrhs; r++) x_i[r] /= l[i * n + i];
+    }
+
+    // D z = y block by block, zero pivots give zero components
+    if (pivoted)
+        for (size_t i = 0; i < n; i += block[i]) {
+            double* x_i = x + i * nrhs;
+            double d11 = l[i * n + i];
+            if (block[i] == 1) {
+                for (size_t r = 0; r < nrhs; r++)
+                    x_i[r] = (d11 == 0.0) ? 0.0 : x_i[r] / d11;
+                continue;
+            }
+            double* x_i1 = x_i + nrhs;
+            double d21 = l[(i + 1) * n + i];
+            double d22 = l[(i + 1) * n + i + 1];
+            double det = block_det(i);
+            for (size_t r = 0; r < nrhs; r++) {
+                double u = x_i[r], v = x_i1[r];
+                x_i[r] = (d22 * u - d21 * v) / det;
+                x_i1[r] = (d11 * v - d21 * u) / det;
+            }
+        }
+
+    // L^T x = y, pushing each solved row up through row i of L
+    for (size_t i = n; i-- > 0;) {
+        double* x_i = x + i * nrhs;
+        if (!pivoted)
+            for (size_t r = 0; r < nrhs; r++) x_i[r] /= l[i * n + i];
+        for (size_t j = 0; j < i; j++) {
+            if (in_d(i, j)) continue;
+            double l_ij = l[i * n + j];
+            double* x_j = x + j * nrhs;
+            for (size_t r = 0; r < nrhs; r++) x_j[r] -= l_ij * x_i[r];
+        }
+    }
+
+    if (pivoted) {
+        vector<double> restored(n * nrhs);
+        for (size_t k = 0; k < n; k++)
+            memcpy(&restored[permutation[k] * nrhs], x + k * nrhs, nrhs * sizeof(double));
+        memcpy(x, restored.data(), n * nrhs * sizeof(double));
+    }
+}
+
+double Cholesky::det() const {
+    if (rank < n) return 0.0;
+
+    double det = 1.0;
+    for (size_t k = 0; k < n; k += pivoted ? block[k] : 1) det *= block_det(k);
+    return det;
+}
+
+double Cholesky::logdet() const {
+    if (rank < n) return -INFINITY;
+
+    double sum = 0.0;
+    for (size_t k = 0; k < n; k += pivoted ? block[k] : 1) sum += log(fabs(block_det(k)));
+    return sum;
+}
+
+Matrix Cholesky::solve(const Matrix& B) const {
+    if (B.rows != n) throw SHAPE_ERROR;
+
+    Matrix X = B;
+    solve_in_place(X.cells, X.columns);
+    return X;
+}
+
+Matrix Cholesky::inverse() const {
+    if (rank < n) throw SINGULAR_ERROR;
+
+    Matrix X = Matrix(n, n).fill_identity();
+    solve_in_place(X.cells, n);
+    return X;
+}
@@ -3,33 +3,86 @@
 #include <stddef.h>
 #include <cstring>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 typedef double MatrixItem;
 
-class Matrix {
+
+class Matrix_Exception : public  std::exception {
+private:
+    std::string msg;
+public:
+    Matrix_Exception(std::string msg) : msg(msg) {};
+};
+
+
+// Elementwise arithmetic is lazy: A + B - C * k builds a tree of expression
+// nodes, and assigning it to a Matrix runs one fused loop over the result.
+// Nodes keep references to Matrix operands, so an expression must be assigned
+// before its operands go out of scope.
+template <class E>
+class MatrixExpr {
+public:
+    const E& self() const { return static_cast<const E&>(*this); }
+};
+
+
+class Matrix;
+class ProductExpr;
+template <class E> class ProductSumExpr;
+
+// Placeholder for a sum made of products only
+struct NoElementwise {};
+
+
+// Matrices are held by reference inside nodes, nested nodes by value
+template <class E>
+struct ExprOperand {
+    typedef const E type;
+};
+
+template <>
+struct ExprOperand<Matrix> {
+    typedef const Matrix& type;
+};
+
+
+class Matrix : public MatrixExpr<Matrix> {
 private:
     size_t rows;
     size_t cols;
     MatrixItem* data;
+
+    void resize(const size_t new_rows, const size_t new_cols);
+    static void gemm(const MatrixItem alpha, const Matrix& A, const Matrix& B, const MatrixItem beta, Matrix& C);
+    template <class E> MatrixItem write_elementwise(const MatrixExpr<E>& expr, const size_t new_rows, const size_t new_cols);
+    MatrixItem write_elementwise(const NoElementwise&, const size_t new_rows, const size_t new_cols);
 public:
     Matrix() : cols(0), rows(0), data(nullptr) {};
     Matrix(const size_t rows, const size_t cols);
     Matrix(const size_t cols, const size_t rows, const MatrixItem* values);
     Matrix(const Matrix& A);
     Matrix(Matrix&& A) noexcept;
+    template <class E> Matrix(const MatrixExpr<E>& expr);
+    Matrix(const ProductExpr& product);
+    template <class E> Matrix(const ProductSumExpr<E>& expr);
     ~Matrix();
 public:
-    Matrix& operator+(const Matrix& A);
-    Matrix& operator-(const Matrix& A);
-    Matrix& operator*(const Matrix& A);
-    Matrix& operator*(const MatrixItem k);
-    Matrix& operator/(const MatrixItem k);
+    size_t get_rows() const { return rows; }
+    size_t get_cols() const { return cols; }
+    MatrixItem operator[](const size_t idx) const { return data[idx]; }
 public:
     Matrix& operator=(const Matrix& A);
     Matrix& operator=(Matrix&& A) noexcept;
+    template <class E> Matrix& operator=(const MatrixExpr<E>& expr);
+    Matrix& operator=(const ProductExpr& product);
+    template <class E> Matrix& operator=(const ProductSumExpr<E>& expr);
 public:
-    Matrix& operator+=(const Matrix& A);
-    Matrix& operator-=(const Matrix& A);
+    template <class E> Matrix& operator+=(const MatrixExpr<E>& expr);
+    template <class E> Matrix& operator-=(const MatrixExpr<E>& expr);
+    Matrix& operator+=(const ProductExpr& product);
+    Matrix& operator-=(const ProductExpr& product);
     Matrix& operator*=(const Matrix& A);
     Matrix& operator/=(const MatrixItem k);
     Matrix& operator*=(const MatrixItem k);
@@ -44,14 +97,382 @@ public:
 };
 
 
-class Matrix_Exception : public  std::exception {
+struct ExprAdd {
+    static MatrixItem apply(const MatrixItem a, const MatrixItem b) { return a + b; }
+};
+
+struct ExprSub {
+    static MatrixItem apply(const MatrixItem a, const MatrixItem b) { return a - b; }
+};
+
+struct ExprMul {
+    static MatrixItem apply(const MatrixItem a, const MatrixItem b) { return a * b; }
+};
+
+struct ExprDiv {
+    static MatrixItem apply(const MatrixItem a, const MatrixItem b) { return a / b; }
+};
+
+
+template <class L, class R, class Op>
+class BinaryExpr : public MatrixExpr< BinaryExpr<L, R, Op> > {
 private:
-    std::string msg;
+    typename ExprOperand<L>::type left;
+    typename ExprOperand<R>::type right;
 public:
-    Matrix_Exception(std::string msg) : msg(msg) {};
+    BinaryExpr(const L& left, const R& right) : left(left), right(right) {};
+    size_t get_rows() const { return left.get_rows(); }
+    size_t get_cols() const { return left.get_cols(); }
+    MatrixItem operator[](const size_t idx) const { return Op::apply(left[idx], right[idx]); }
+};
+
+
+template <class E, class Op>
+class ScalarExpr : public MatrixExpr< ScalarExpr<E, Op> > {
+private:
+    typename ExprOperand<E>::type operand;
+    MatrixItem k;
+public:
+    ScalarExpr(const E& operand, const MatrixItem k) : operand(operand), k(k) {};
+    size_t get_rows() const { return operand.get_rows(); }
+    size_t get_cols() const { return operand.get_cols(); }
+    MatrixItem operator[](const size_t idx) const { return Op::apply(operand[idx], k); }
+};
+
+
+// alpha * left * right, evaluated by Matrix::gemm when assigned
+class ProductExpr {
+public:
+    const Matrix& left;
+    const Matrix& right;
+    MatrixItem alpha;
+
+    ProductExpr(const Matrix& left, const Matrix& right, const MatrixItem alpha)
+        : left(left), right(right), alpha(alpha) {};
+};
+
+
+// elementwise + the sum of the products: the elementwise part is written in
+// one fused pass, then gemm accumulates every product into it with beta = 1.
+// Without an elementwise part the first product is written with beta = 0.
+template <class E>
+class ProductSumExpr {
+public:
+    typename ExprOperand<E>::type elementwise;
+    std::vector<ProductExpr> products;
+
+    ProductSumExpr(const E& elementwise, const std::vector<ProductExpr>& products)
+        : elementwise(elementwise), products(products) {};
+    size_t get_rows() const { return products[0].left.get_rows(); }
+    size_t get_cols() const { return products[0].right.get_cols(); }
 };
 
 
+// SUM = B + A
+template <class L, class R>
+BinaryExpr<L, R, ExprAdd> operator+(const MatrixExpr<L>& B, const MatrixExpr<R>& A)
+{
+    if (A.self().get_cols() != B.self().get_cols() || A.self().get_rows() != B.self().get_rows())
+        throw Matrix_Exception("Operator+: Incorrect sizes");
+
+    return BinaryExpr<L, R, ExprAdd>(B.self(), A.self());
+}
+
+
+// SUB = B - A
+template <class L, class R>
+BinaryExpr<L, R, ExprSub> operator-(const MatrixExpr<L>& B, const MatrixExpr<R>& A)
+{
+    if (A.self().get_cols() != B.self().get_cols() || A.self().get_rows() != B.self().get_rows())
+        throw Matrix_Exception("Operator-: Incorrect sizes");
+
+    return BinaryExpr<L, R, ExprSub>(B.self(), A.self());
+}
+
+
+// C = A * k
+template <class E>
+ScalarExpr<E, ExprMul> operator*(const MatrixExpr<E>& A, const MatrixItem k)
+{
+    return ScalarExpr<E, ExprMul>(A.self(), k);
+}
+
+
+// C = A / k
+template <class E>
+ScalarExpr<E, ExprDiv> operator/(const MatrixExpr<E>& A, const MatrixItem k)
+{
+    return ScalarExpr<E, ExprDiv>(A.self(), k);
+}
+
+
+//C = B * A
+inline ProductExpr operator*(const Matrix& B, const Matrix& A)
+{
+    if (B.get_cols() != A.get_rows())
+        throw Matrix_Exception("Operator*: Multiplication Error");
+
+    return ProductExpr(B, A, 1.);
+}
+
+
+inline ProductExpr operator*(const ProductExpr& P, const MatrixItem k)
+{
+    return ProductExpr(P.left, P.right, P.alpha * k);
+}
+
+
+inline ProductExpr operator/(const ProductExpr& P, const MatrixItem k)
+{
+    return ProductExpr(P.left, P.right, P.alpha / k);
+}
+
+
+// Building blocks of the sums below. The elementwise parts are joined into
+// one node, and a missing part on either side simply drops out.
+template <class E>
+ProductSumExpr<E> make_sum(const E& elementwise, const std::vector<ProductExpr>& products)
+{
+    return ProductSumExpr<E>(elementwise, products);
+}
+
+
+inline ProductSumExpr<NoElementwise> make_sum(const ProductExpr& P)
+{
+    return ProductSumExpr<NoElementwise>(NoElementwise(), std::vector<ProductExpr>(1, P));
+}
+
+
+template <class L, class R, class Op>
+BinaryExpr<L, R, Op> join(const L& left, const R& right, Op)
+{
+    return BinaryExpr<L, R, Op>(left, right);
+}
+
+template <class R>
+const R& join(const NoElementwise&, const R& right, ExprAdd) { return right; }
+
+template <class R>
+ScalarExpr<R, ExprMul> join(const NoElementwise&, const R& right, ExprSub) { return ScalarExpr<R, ExprMul>(right, -1.); }
+
+template <class L, class Op>
+const L& join(const L& left, const NoElementwise&, Op) { return left; }
+
+inline NoElementwise join(const NoElementwise&, const NoElementwise&, ExprAdd) { return NoElementwise(); }
+inline NoElementwise join(const NoElementwise&, const NoElementwise&, ExprSub) { return NoElementwise(); }
+
+
+template <class E>
+ScalarExpr<E, ExprMul> scaled(const E& elementwise, const MatrixItem k) { return ScalarExpr<E, ExprMul>(elementwise, k); }
+inline NoElementwise scaled(const NoElementwise&, const MatrixItem) { return NoElementwise(); }
+
+
+// left products followed by the right ones times k
+inline std::vector<ProductExpr> concat(const std::vector<ProductExpr>& left, const std::vector<ProductExpr>& right, const MatrixItem k)
+{
+    std::vector<ProductExpr> products;
+    products.reserve(left.size() + right.size());
+    for (const ProductExpr& P : left)
+        products.push_back(P);
+    for (const ProductExpr& P : right)
+        products.push_back(P * k);
+    return products;
+}
+
+
+inline void check_sum_sizes(const size_t rows, const size_t cols, const size_t other_rows, const size_t other_cols, const char* msg)
+{
+    if (rows != other_rows || cols != other_cols)
+        throw Matrix_Exception(msg);
+}
+
+
+template <class L, class R>
+auto operator+(const ProductSumExpr<L>& S, const ProductSumExpr<R>& T)
+    -> decltype(make_sum(join(S.elementwise, T.elementwise, ExprAdd()), S.products))
+{
+    check_sum_sizes(S.get_rows(), S.get_cols(), T.get_rows(), T.get_cols(), "Operator+: Incorrect sizes");
+    return make_sum(join(S.elementwise, T.elementwise, ExprAdd()), concat(S.products, T.products, 1.));
+}
+
+
+template <class L, class R>
+auto operator-(const ProductSumExpr<L>& S, const ProductSumExpr<R>& T)
+    -> decltype(make_sum(join(S.elementwise, T.elementwise, ExprSub()), S.products))
+{
+    check_sum_sizes(S.get_rows(), S.get_cols(), T.get_rows(), T.get_cols(), "Operator-: Incorrect sizes");
+    return make_sum(join(S.elementwise, T.elementwise, ExprSub()), concat(S.products, T.products, -1.));
+}
+
+
+template <class L, class R>
+auto operator+(const ProductSumExpr<L>& S, const MatrixExpr<R>& B)
+    -> decltype(make_sum(join(S.elementwise, B.self(), ExprAdd()), S.products))
+{
+    check_sum_sizes(S.get_rows(), S.get_cols(), B.self().get_rows(), B.self().get_cols(), "Operator+: Incorrect sizes");
+    return make_sum(join(S.elementwise, B.self(), ExprAdd()), S.products);
+}
+
+
+template <class L, class R>
+auto operator-(const ProductSumExpr<L>& S, const MatrixExpr<R>& B)
+    -> decltype(make_sum(join(S.elementwise, B.self(), ExprSub()), S.products))
+{
+    check_sum_sizes(S.get_rows(), S.get_cols(), B.self().get_rows(), B.self().get_cols(), "Operator-: Incorrect sizes");
+    return make_sum(join(S.elementwise, B.self(), ExprSub()), S.products);
+}
+
+
+template <class L, class R>
+auto operator+(const MatrixExpr<L>& B, const ProductSumExpr<R>& S)
+    -> decltype(make_sum(join(B.self(), S.elementwise, ExprAdd()), S.products))
+{
+    check_sum_sizes(S.get_rows(), S.get_cols(), B.self().get_rows(), B.self().get_cols(), "Operator+: Incorrect sizes");
+    return make_sum(join(B.self(), S.elementwise, ExprAdd()), S.products);
+}
+
+
+template <class L, class R>
+auto operator-(const MatrixExpr<L>& B, const ProductSumExpr<R>& S)
+    -> decltype(make_sum(join(B.self(), S.elementwise, ExprSub()), S.products))
+{
+    check_sum_sizes(S.get_rows(), S.get_cols(), B.self().get_rows(), B.self().get_cols(), "Operator-: Incorrect sizes");
+    return make_sum(join(B.self(), S.elementwise, ExprSub()), concat(std::vector<ProductExpr>(), S.products, -1.));
+}
+
+
+template <class E>
+auto operator*(const ProductSumExpr<E>& S, const MatrixItem k)
+    -> decltype(make_sum(scaled(S.elementwise, k), S.products))
+{
+    return make_sum(scaled(S.elementwise, k), concat(std::vector<ProductExpr>(), S.products, k));
+}
+
+
+template <class E>
+auto operator/(const ProductSumExpr<E>& S, const MatrixItem k)
+    -> decltype(S * k)
+{
+    return S * (1. / k);
+}
+
+
+// A single product joins a sum as a sum of its own
+template <class E>
+auto operator+(const ProductSumExpr<E>& S, const ProductExpr& P) -> decltype(S + make_sum(P)) { return S + make_sum(P); }
+
+template <class E>
+auto operator-(const ProductSumExpr<E>& S, const ProductExpr& P) -> decltype(S - make_sum(P)) { return S - make_sum(P); }
+
+template <class E>
+auto operator+(const ProductExpr& P, const ProductSumExpr<E>& S) -> decltype(make_sum(P) + S) { return make_sum(P) + S; }
+
+template <class E>
+auto operator-(const ProductExpr& P, const ProductSumExpr<E>& S) -> decltype(make_sum(P) - S) { return make_sum(P) - S; }
+
+template <class E>
+auto operator+(const MatrixExpr<E>& B, const ProductExpr& P) -> decltype(B + make_sum(P)) { return B + make_sum(P); }
+
+template <class E>
+auto operator-(const MatrixExpr<E>& B, const ProductExpr& P) -> decltype(B - make_sum(P)) { return B - make_sum(P); }
+
+template <class E>
+auto operator+(const ProductExpr& P, const MatrixExpr<E>& B) -> decltype(make_sum(P) + B) { return make_sum(P) + B; }
+
+template <class E>
+auto operator-(const ProductExpr& P, const MatrixExpr<E>& B) -> decltype(make_sum(P) - B) { return make_sum(P) - B; }
+
+inline ProductSumExpr<NoElementwise> operator+(const ProductExpr& P, const ProductExpr& Q) { return make_sum(P) + make_sum(Q); }
+
+inline ProductSumExpr<NoElementwise> operator-(const ProductExpr& P, const ProductExpr& Q) { return make_sum(P) - make_sum(Q); }
+
+
+template <class E>
+Matrix::Matrix(const MatrixExpr<E>& expr)
+    : Matrix(expr.self().get_rows(), expr.self().get_cols())
+{
+    *this = expr;
+}
+
+
+template <class E>
+Matrix::Matrix(const ProductSumExpr<E>& expr)
+    : Matrix(expr.get_rows(), expr.get_cols())
+{
+    *this = expr;
+}
+
+
+// One pass over the result, whatever the depth of the expression
+template <class E>
+Matrix& Matrix::operator=(const MatrixExpr<E>& expr)
+{
+    const E& A = expr.self();
+    resize(A.get_rows(), A.get_cols());
+
+    for (size_t idx = 0; idx < rows * cols; ++idx)
+        data[idx] = A[idx];
+    return *this;
+}
+
+
+template <class E>
+Matrix& Matrix::operator=(const ProductSumExpr<E>& expr)
+{
+    for (const ProductExpr& P : expr.products) {
+        if (&P.left == this || &P.right == this) {
+            Matrix C(expr);
+            return *this = std::move(C);
+        }
+    }
+
+    MatrixItem beta = write_elementwise(expr.elementwise, expr.get_rows(), expr.get_cols());
+    for (const ProductExpr& P : expr.products) {
+        gemm(P.alpha, P.left, P.right, beta, *this);
+        beta = 1.;
+    }
+    return *this;
+}
+
+
+// Elementwise part of a sum: 1 tells gemm to add onto it, 0 to overwrite
+template <class E>
+MatrixItem Matrix::write_elementwise(const MatrixExpr<E>& expr, const size_t, const size_t)
+{
+    *this = expr;
+    return 1.;
+}
+
+
+// B += A
+template <class E>
+Matrix& Matrix::operator+=(const MatrixExpr<E>& expr)
+{
+    const E& A = expr.self();
+    if (A.get_cols() != cols || A.get_rows() != rows)
+        throw Matrix_Exception("Operator+=: Incorrect sizes");
+
+    for (size_t idx = 0; idx < rows * cols; ++idx)
+        data[idx] += A[idx];
+
+    return *this;
+}
+
+
+// B -= A
+template <class E>
+Matrix& Matrix::operator-=(const MatrixExpr<E>& expr)
+{
+    const E& A = expr.self();
+    if (A.get_cols() != cols || A.get_rows() != rows)
+        throw Matrix_Exception("Operator-=: Incorrect sizes");
+
+    for (size_t idx = 0; idx < rows * cols; ++idx)
+        data[idx] -= A[idx];
+    return *this;
+}
+
+
 Matrix::Matrix(const size_t rows, const size_t cols)
     : cols(cols), rows(rows)
 {
@@ -78,7 +499,25 @@ Matrix::Matrix(const Matrix& A)
     rows = A.rows;
     cols = A.cols;
     data = new MatrixItem[rows * cols];
-    std::memcpy(data, A.data, sizeof(MatrixItem));
+    std::memcpy(data, A.data, rows * cols * sizeof(MatrixItem));
+}
+
+
+Matrix::Matrix(const ProductExpr& product)
+    : Matrix(product.left.rows, product.right.cols)
+{
+    gemm(product.alpha, product.left, product.right, 0., *this);
+}
+
+
+void Matrix::resize(const size_t new_rows, const size_t new_cols)
+{
+    if (rows * cols != new_rows * new_cols) {
+        delete[] data;
+        data = new MatrixItem[new_rows * new_cols];
+    }
+    rows = new_rows;
+    cols = new_cols;
 }
 
 
@@ -167,50 +606,42 @@ Matrix& Matrix::operator=(const Matrix& A)
 }
 
 
-// B += A
-Matrix& Matrix::operator+=(const Matrix& A) {
-    if (A.cols != cols || A.rows != rows)
-        throw Matrix_Exception("Operator+=: Incorrect sizes");
-
-    for (size_t idx = 0; idx < A.cols * A.rows; ++idx)
-        data[idx] += A.data[idx];
+Matrix& Matrix::operator=(const ProductExpr& product)
+{
+    if (&product.left == this || &product.right == this) {
+        Matrix C(product);
+        return *this = std::move(C);
+    }
 
+    resize(product.left.rows, product.right.cols);
+    gemm(product.alpha, product.left, product.right, 0., *this);
     return *this;
 }
 
 
-// SUM = B + A
-Matrix& Matrix::operator+(const Matrix& A) {
-    if (A.cols != cols || A.rows != rows)
-        throw Matrix_Exception("Operator+: Incorrect sizes");
-
-    Matrix* SUM = new Matrix(*this);
-    *SUM += A;
-    return *SUM;
+MatrixItem Matrix::write_elementwise(const NoElementwise&, const size_t new_rows, const size_t new_cols)
+{
+    resize(new_rows, new_cols);
+    return 0.;
 }
 
 
-// B -= A
-Matrix& Matrix::operator-=(const Matrix& A)
+Matrix& Matrix::operator+=(const ProductExpr& product)
 {
-    if (A.cols != cols || A.rows != rows)
-        throw Matrix_Exception("Operator-=: Incorrect sizes");
+    if (product.left.rows != rows || product.right.cols != cols)
+        throw Matrix_Exception("Operator+=: Incorrect sizes");
+
+    if (&product.left == this || &product.right == this)
+        return *this += Matrix(product);
 
-    for (size_t idx = 0; idx < A.cols * A.rows; ++idx)
-        data[idx] -= A.data[idx];
+    gemm(product.alpha, product.left, product.right, 1., *this);
     return *this;
 }
 
 
-// SUB = B - A
-Matrix& Matrix::operator-(const Matrix& A) {
-    if (A.cols != cols || A.rows != rows)
-        throw Matrix_Exception("Operator-: Incorrect sizes");
-
-    Matrix* SUB = new Matrix(*this);
-    *SUB -= A;
-
-    return *SUB;
+Matrix& Matrix::operator-=(const ProductExpr& product)
+{
+    return *this += ProductExpr(product.left, product.right, -product.alpha);
 }
 
 
@@ -227,24 +658,34 @@ Matrix& Matrix::trans()
 }
 
 
-//C = B * A
-Matrix& Matrix::operator*(const Matrix& A)
+// C = alpha * A * B + beta * C, C must not alias A or B. The alpha and beta
+// scaling happens inside the kernel, so * k, / k and + X after a product cost
+// no extra pass over C.
+void Matrix::gemm(const MatrixItem alpha, const Matrix& A, const Matrix& B, const MatrixItem beta, Matrix& C)
 {
-    if (A.cols != rows)
-        throw Matrix_Exception("Operator*: Multiplication Error");
+    const size_t block = 256;
+
+    for (size_t row = 0; row < C.rows; ++row) {
+        MatrixItem* C_row = C.data + row * C.cols;
+        for (size_t col = 0; col < C.cols; ++col)
+            C_row[col] = (beta == 0.) ? 0. : beta * C_row[col];
+    }
+
+    for (size_t begin = 0; begin < A.cols; begin += block) {
+        size_t end = (begin + block < A.cols) ? begin + block : A.cols;
 
-    Matrix* C = new Matrix(rows, A.cols);
+        for (size_t row = 0; row < C.rows; ++row) {
+            MatrixItem* C_row = C.data + row * C.cols;
 
-    for (size_t col = 0; col < cols; ++col) {
-        for (size_t rowA = 0; rowA < A.rows; ++rowA) {
-            C->data[rowA * cols + col] = 0;
-            for (size_t idx = 0; idx < A.cols; ++idx) {
-                C->data[rowA * cols + col] += A.data[rowA * A.cols + idx]
-                    * data[idx * cols + col];
+            for (size_t idx = begin; idx < end; ++idx) {
+                const MatrixItem factor = alpha * A.data[row * A.cols + idx];
+                const MatrixItem* B_row = B.data + idx * B.cols;
+
+                for (size_t col = 0; col < C.cols; ++col)
+                    C_row[col] += factor * B_row[col];
             }
         }
-    };
-    return *C;
+    }
 }
 
 
@@ -265,28 +706,6 @@ Matrix& Matrix::operator/=(const MatrixItem k)
 }
 
 
-// C = A / k
-Matrix& Matrix::operator/(const MatrixItem k)
-{
-    Matrix* C = new Matrix(rows, cols);
-
-    for (size_t idx = 0; idx < cols * rows; ++idx)
-        C->data[idx] = data[idx] / k;
-    return *C;
-}
-
-
-// C = A * k
-Matrix& Matrix::operator*(const MatrixItem k)
-{
-    Matrix* C = new Matrix(rows, cols);
-
-    for (size_t idx = 0; idx < cols * rows; ++idx)
-        C->data[idx] = data[idx] * k;
-    return *C;
-}
-
-
 // A *= k
 Matrix& Matrix::operator*=(const MatrixItem k)
 {
@@ -338,3 +757,46 @@ Matrix& Matrix::exp(unsigned int idx)
     }
     return *exp;
 }
+
+
+// Products mixed with each other and with elementwise terms
+int main()
+{
+    const MatrixItem a_values[] = { 1., 2., 3., 4. };
+    const MatrixItem b_values[] = { 0., 1., -1., 2. };
+    const MatrixItem sum_values[] = { 14., 20., 30., 44. };   // A*A + A*A
+    const MatrixItem diff_values[] = { 4., 6., 10., 16. };     // A*A - B*A
+    const MatrixItem mixed_values[] = { 12., 17., 29., 40. }; // A*A*2 - B*A + A - B
+    Matrix A(2, 2, a_values);
+    Matrix B(2, 2, b_values);
+
+    Matrix sum = A * A + A * A;
+    Matrix diff(2, 2);
+    diff = A * A - B * A;
+    Matrix mixed = A * A * 2. - B * A;
+    mixed += A - B;
+
+    // Products chained with other terms, against the materialized products
+    const MatrixItem c_values[] = { 2., -1., 0., 3. };
+    Matrix C(2, 2, c_values);
+    Matrix D = B - A;
+    Matrix AB = A * B;
+    Matrix CD = C * D;
+    Matrix BC = B * C;
+    Matrix DD = D * 2.;
+    Matrix chains[] = { A * B + C * D + C, A * B - C + D, A + B * C + D, A + B * C - D * 2.,
+        C - A * B - C * D * 3. };
+    Matrix chain_refs[] = { AB + CD + C, AB - C + D, A + BC + D, A + BC - DD, C - AB - CD * 3. };
+
+    A = A * A + A * A;  // operands alias the result
+
+    bool ok = true;
+    for (size_t idx = 0; idx < 4; ++idx) {
+        ok = ok && sum[idx] == sum_values[idx] && diff[idx] == diff_values[idx]
+            && mixed[idx] == mixed_values[idx] && A[idx] == sum_values[idx];
+        for (size_t chain = 0; chain < 5; ++chain)
+            ok = ok && chains[chain][idx] == chain_refs[chain][idx];
+    }
+    std::cout << (ok ? "SUCCESS" : "FAIL") << " mixed product expressions" << std::endl;
+    return ok ? 0 : 1;
+}
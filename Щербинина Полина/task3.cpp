@@ -1,42 +1,42 @@
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 
-#include "matrix.hpp"
+#include "task3.hpp"
 
 template <typename Type>
 Matrix<Type>::Matrix(std::initializer_list<std::initializer_list<Type>> matrix)
     : rows(matrix.size()), cols(rows > 0 ? matrix.begin()->size() : 0)
 {
+    elements.reserve(rows * cols);
+
     for (const auto &mat : matrix)
     {
-        std::vector<Type> row(mat);
-        elements.push_back(row);
+        if (mat.size() != cols)
+            throw std::invalid_argument("All matrix rows must have the same length.");
+
+        elements.insert(elements.end(), mat.begin(), mat.end());
     }
 }
 
 template <typename Type>
 Matrix<Type>::Matrix(unsigned int _rows, unsigned int _cols, Type _init)
-    : rows(_rows), cols(_cols)
+    : elements(_rows * _cols, _init), rows(_rows), cols(_cols)
 {
-    elements.resize(_rows, std::vector<Type>(_cols, _init));
 }
 
 template <typename Type>
 Matrix<Type>::Matrix(std::initializer_list<Type> matrix)
-    : rows(1), cols(matrix.size())
+    : elements(matrix), rows(1), cols(matrix.size())
 {
-    std::vector<Type> row(matrix);
-    elements.push_back(row);
 }
 
 template <typename Type>
 Matrix<Type>::Matrix(unsigned _size)
-    : rows(_size), cols(_size)
+    : elements(_size * _size, Type{0}), rows(_size), cols(_size)
 {
-    elements.resize(_size, std::vector<Type>(_size, Type{0}));
-
     for (unsigned i = 0; i < _size; i++)
-        elements[i][i] = Type{1};
+        elements[i * cols + i] = Type{1};
 }
 
 template <typename Type>
@@ -67,11 +67,10 @@ Matrix<Type> Matrix<Type>::operator+(const Matrix<Type> &right) const
     if (rows != right.rows || cols != right.cols)
         throw std::invalid_argument("Matrix addition requires matrices of the same dimensions.");
 
-    Matrix result(rows, cols, elements[0][0]);
+    Matrix result(rows, cols, Type{0});
 
-    for (unsigned i = 0; i < rows; i++)
-        for (unsigned j = 0; j < cols; j++)
-            result.elements[i][j] = elements[i][j] + right.elements[i][j];
+    for (std::size_t idx = 0; idx < elements.size(); idx++)
+        result.elements[idx] = elements[idx] + right.elements[idx];
 
     return result;
 }
@@ -82,9 +81,8 @@ Matrix<Type> &Matrix<Type>::operator+=(const Matrix<Type> &right)
     if (rows != right.rows || cols != right.cols)
         throw std::invalid_argument("Matrix addition requires matrices of the same dimensions.");
 
-    for (unsigned i = 0; i < rows; i++)
-        for (unsigned j = 0; j < cols; j++)
-            elements[i][j] += right.elements[i][j];
+    for (std::size_t idx = 0; idx < elements.size(); idx++)
+        elements[idx] += right.elements[idx];
 
     return *this;
 }
@@ -95,11 +93,10 @@ Matrix<Type> Matrix<Type>::operator-(const Matrix<Type> &right) const
     if (rows != right.rows || cols != right.cols)
         throw std::invalid_argument("Matrix subtraction requires matrices of the same dimensions.");
 
-    Matrix result(rows, cols, elements[0][0]);
+    Matrix result(rows, cols, Type{0});
 
-    for (unsigned i = 0; i < rows; i++)
-        for (unsigned j = 0; j < cols; j++)
-            result.elements[i][j] = elements[i][j] - right.elements[i][j];
+    for (std::size_t idx = 0; idx < elements.size(); idx++)
+        result.elements[idx] = elements[idx] - right.elements[idx];
 
     return result;
 }
@@ -110,9 +107,8 @@ Matrix<Type> &Matrix<Type>::operator-=(const Matrix<Type> &right)
     if (rows != right.rows || cols != right.cols)
         throw std::invalid_argument("Matrix subtraction requires matrices of the same dimensions.");
 
-    for (unsigned i = 0; i < rows; i++)
-        for (unsigned j = 0; j < cols; j++)
-            elements[i][j] -= right.elements[i][j];
+    for (std::size_t idx = 0; idx < elements.size(); idx++)
+        elements[idx] -= right.elements[idx];
 
     return *this;
 }
@@ -123,22 +119,33 @@ Matrix<Type> Matrix<Type>::operator*(const Matrix<Type> &right) const
     if (cols != right.rows)
         throw std::invalid_argument("Matrices are incompatible for multiplication");
 
-    Matrix result(rows, right.cols, elements[0][0]);
+    Matrix result(rows, right.cols, Type{0});
+    multiply_into(*this, right, result);
 
-    for (unsigned int i = 0; i < rows; i++)
+    return result;
+}
+
+// c = a * b into c's existing buffer, which must not be a's or b's.
+// i-k-j order: the inner loop walks one row of b and one row of c
+template <typename Type>
+void Matrix<Type>::multiply_into(const Matrix<Type> &a, const Matrix<Type> &b, Matrix<Type> &c)
+{
+    for (unsigned int i = 0; i < a.rows; i++)
     {
-        for (unsigned int j = 0; j < right.cols; j++)
-        {
-            Type sum = 0;
+        Type *c_row = &c.elements[i * c.cols];
+
+        for (unsigned int j = 0; j < b.cols; j++)
+            c_row[j] = Type{0};
 
-            for (unsigned int k = 0; k < cols; k++)
-                sum += elements[i][k] * right.elements[k][j];
+        for (unsigned int k = 0; k < a.cols; k++)
+        {
+            const Type factor = a.elements[i * a.cols + k];
+            const Type *b_row = &b.elements[k * b.cols];
 
-            result.elements[i][j] = sum;
+            for (unsigned int j = 0; j < b.cols; j++)
+                c_row[j] += factor * b_row[j];
         }
     }
-
-    return result;
 }
 
 template <typename Type>
@@ -151,11 +158,10 @@ Matrix<Type> &Matrix<Type>::operator*=(const Matrix<Type> &right)
 template <typename Type>
 Matrix<Type> Matrix<Type>::operator+(const Type &right) const
 {
-    Matrix result(rows, cols, elements[0][0]);
+    Matrix result(rows, cols, Type{0});
 
-    for (unsigned i = 0; i < rows; i++)
-        for (unsigned j = 0; j < cols; j++)
-            result.elements[i][j] = this->elements[i][j] + right;
+    for (std::size_t idx = 0; idx < elements.size(); idx++)
+        result.elements[idx] = elements[idx] + right;
 
     return result;
 }
@@ -166,11 +172,10 @@ Matrix<Type> Matrix<Type>::operator/(const Type &right) const
     if (right == 0)
         throw std::invalid_argument("Division by zero.");
 
-    Matrix result(rows, cols, elements[0][0]);
+    Matrix result(rows, cols, Type{0});
 
-    for (unsigned i = 0; i < rows; i++)
-        for (unsigned j = 0; j < cols; j++)
-            result.elements[i][j] = this->elements[i][j] / right;
+    for (std::size_t idx = 0; idx < elements.size(); idx++)
+        result.elements[idx] = elements[idx] / right;
 
     return result;
 }
@@ -178,11 +183,10 @@ Matrix<Type> Matrix<Type>::operator/(const Type &right) const
 template <typename Type>
 Matrix<Type> Matrix<Type>::operator-(const Type &right) const
 {
-    Matrix result(rows, cols, elements[0][0]);
+    Matrix result(rows, cols, Type{0});
 
-    for (unsigned i = 0; i < rows; i++)
-        for (unsigned j = 0; j < cols; j++)
-            result.elements[i][j] = this->elements[i][j] - right;
+    for (std::size_t idx = 0; idx < elements.size(); idx++)
+        result.elements[idx] = elements[idx] - right;
 
     return result;
 }
@@ -190,11 +194,10 @@ Matrix<Type> Matrix<Type>::operator-(const Type &right) const
 template <typename Type>
 Matrix<Type> Matrix<Type>::operator*(const Type &right) const
 {
-    Matrix result(rows, cols, elements[0][0]);
+    Matrix result(rows, cols, Type{0});
 
-    for (unsigned i = 0; i < rows; i++)
-        for (unsigned j = 0; j < cols; j++)
-            result.elements[i][j] = this->elements[i][j] * right;
+    for (std::size_t idx = 0; idx < elements.size(); idx++)
+        result.elements[idx] = elements[idx] * right;
 
     return result;
 }
@@ -235,7 +238,7 @@ Type &Matrix<Type>::operator()(const unsigned &i, const unsigned &j)
         throw std::out_of_range("Matrix index out of bounds!");
     }
 
-    return elements[i][j];
+    return elements[i * cols + j];
 }
 
 template <typename Type>
@@ -244,7 +247,7 @@ void Matrix<Type>::print() const
     for (unsigned int i = 0; i < rows; i++)
     {
         for (unsigned int j = 0; j < cols; j++)
-            std::cout << elements[i][j] << " ";
+            std::cout << elements[i * cols + j] << " ";
 
         std::cout << std::endl;
     }
@@ -266,7 +269,7 @@ Type &Matrix<Type>::element(unsigned &i, unsigned &j)
                                  "Index (" + std::to_string(i) + ", " + std::to_string(j) + ")"
                                  " in file " + std::string(__FILE__) + " at line " + std::to_string(__LINE__));
     }
-    return elements[i][j];
+    return elements[i * cols + j];
 }
 
 template <typename Type>
@@ -284,7 +287,7 @@ Type &Matrix<Type>::element(unsigned &i)
     if (rows == 0 && cols == 0)
         throw std::runtime_error("Matrix is empty! Index out of bounds!");
 
-    return this->elements[0][i];
+    return elements[i];
 }
 
 template <typename Type>
@@ -303,7 +306,7 @@ Type &Matrix<Type>::element(const unsigned &i, const unsigned &j)
                                  "Index (" + std::to_string(i) + ", " + std::to_string(j) + ")"
                                  " in file " + std::string(__FILE__) + " at line " + std::to_string(__LINE__));
     }
-    return elements[i][j];
+    return elements[i * cols + j];
 }
 
 template <typename Type>
@@ -321,17 +324,29 @@ Type &Matrix<Type>::element(const unsigned &i)
     if (rows == 0 && cols == 0)
         throw std::runtime_error("Matrix is empty! Index out of bounds!");
 
-    return this->elements[0][i];
+    return elements[i];
 }
 
 template <typename Type>
 Matrix<Type> Matrix<Type>::transpose() const
 {
-    Matrix<Type> result(cols, rows, elements[0][0]);
+    // Square tiles keep both the reads and the strided writes inside the cache
+    const unsigned int tile = 32;
+    Matrix<Type> result(cols, rows, Type{0});
 
-    for (unsigned int i = 0; i < rows; i++)
-        for (unsigned int j = 0; j < cols; j++)
-            result.elements[j][i] = elements[i][j];
+    for (unsigned int i0 = 0; i0 < rows; i0 += tile)
+    {
+        const unsigned int i1 = std::min(rows, i0 + tile);
+
+        for (unsigned int j0 = 0; j0 < cols; j0 += tile)
+        {
+            const unsigned int j1 = std::min(cols, j0 + tile);
+
+            for (unsigned int i = i0; i < i1; i++)
+                for (unsigned int j = j0; j < j1; j++)
+                    result.elements[j * rows + i] = elements[i * cols + j];
+        }
+    }
 
     return result;
 }
@@ -355,10 +370,38 @@ Matrix<Type> Matrix<Type>::power(unsigned n) const
         throw std::invalid_argument("Matrix is incompatible for power() | rows != cols\n");
     }
 
-    Matrix result(rows, cols, elements[0][0]);
-    result = *this;
+    // Exponentiation by squaring: base and result each ping-pong with one scratch buffer
+    Matrix base(*this);
+    Matrix result(*this);
+    Matrix scratch(rows, cols, Type{0});
+    bool started = false;
+
+    for (;;)
+    {
+        if (n & 1u)
+        {
+            if (started)
+            {
+                multiply_into(result, base, scratch);
+                result.elements.swap(scratch.elements);
+            }
+            else
+            {
+                result.elements = base.elements;
+                started = true;
+            }
+        }
+
+        n >>= 1;
 
-    return result * result.power(n - 1);
+        if (n == 0)
+            break;
+
+        multiply_into(base, base, scratch);
+        base.elements.swap(scratch.elements);
+    }
+
+    return result;
 }
 
 template <typename Type>
@@ -372,3 +415,23 @@ unsigned Matrix<Type>::getCols() const
 {
     return cols;
 }
+
+template class Matrix<int>;
+template class Matrix<double>;
+
+int main()
+{
+    Matrix<int> A = {{1, 1}, {1, 0}};
+    Matrix<int> F = {{233, 144}, {144, 89}};  // A^n holds Fibonacci numbers
+    Matrix<double> B = {{2.0, 0.0}, {0.0, 0.5}};
+    Matrix<double> C = {{1.0, 2.0, 3.0}, {4.0, 5.0, 6.0}};
+    Matrix<double> CT = {{1.0, 4.0}, {2.0, 5.0}, {3.0, 6.0}};
+
+    bool ok = A.power(12) == F && A.power(13) == F * A && A.power(0) == Matrix<int>(2) && A.power(1) == A
+              && B.power(10) == Matrix<double>({{1024.0, 0.0}, {0.0, 1.0 / 1024.0}})
+              && C.transpose() == CT && (C * CT)(1, 1) == 77.0
+              && (C + C - C * 2.0) == Matrix<double>(2, 3, 0.0);
+
+    std::cout << (ok ? "SUCCESS" : "FAIL") << " power, transpose and arithmetic" << std::endl;
+    return ok ? 0 : 1;
+}
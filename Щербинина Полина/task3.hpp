@@ -10,10 +10,12 @@
 template <typename Type> class Matrix
 {
     private:
-            std::vector< std::vector<Type> > elements;
+            std::vector<Type> elements;  // row-major, element (i, j) at i * cols + j
             unsigned int rows;
             unsigned int cols;
 
+            static void multiply_into(const Matrix<Type> & a, const Matrix<Type> & b, Matrix<Type> & c);
+
     public:
 
             
@@ -29,18 +31,18 @@ template <typename Type> class Matrix
 
 
             Matrix<Type> & operator= (const Matrix<Type> & right);
-            Matrix<Type>   operator+ (const Matrix<Type> & right);
+            Matrix<Type>   operator+ (const Matrix<Type> & right) const;
             Matrix<Type> & operator+=(const Matrix<Type> & right);
-            Matrix<Type>   operator- (const Matrix<Type> & right);
+            Matrix<Type>   operator- (const Matrix<Type> & right) const;
             Matrix<Type> & operator-=(const Matrix<Type> & right);
-            Matrix<Type>   operator* (const Matrix<Type> & right);
+            Matrix<Type>   operator* (const Matrix<Type> & right) const;
             Matrix<Type> & operator*=(const Matrix<Type> & right);
 
             //scalar
-            Matrix<Type> operator+(const Type & right);
-            Matrix<Type> operator-(const Type & right);
-            Matrix<Type> operator*(const Type & right);
-            Matrix<Type> operator/(const Type & right);
+            Matrix<Type> operator+(const Type & right) const;
+            Matrix<Type> operator-(const Type & right) const;
+            Matrix<Type> operator*(const Type & right) const;
+            Matrix<Type> operator/(const Type & right) const;
             Matrix<Type> & operator+=(const Type & right);
             Matrix<Type> & operator-=(const Type & right);
             Matrix<Type> & operator*=(const Type & right);
@@ -52,11 +54,7 @@ template <typename Type> class Matrix
             {
               if (m1.rows != m2.rows || m1.cols != m2.cols) return false;
 
-              for (unsigned i = 0; i < m1.rows; i++)
-               for (unsigned j = 0; j < m1.cols; j++)
-                if (m1.elements[i][j] != m2.elements[i][j]) return false;
-
-              return true;
+              return m1.elements == m2.elements;
             }
 
             friend bool operator!=(const Matrix<Type> & m1, const Matrix<Type> & m2) { return m1 == m2 ? false : true; }
@@ -65,19 +63,17 @@ template <typename Type> class Matrix
             friend Matrix<Type> operator-(const Type & value, Matrix<Type> & right) { return right - value; }
 
     
-            void print();
+            void print() const;
             unsigned getRows() const;
             unsigned getCols() const;
             Type & element(unsigned & i, unsigned & j);
             Type & element(const unsigned & i, const unsigned & j);
             Type & element(unsigned & i);
             Type & element(const unsigned & i);
-            bool is_square() {return cols == rows;}
+            bool is_square() const {return cols == rows;}
             Matrix<Type> transpose() const;
-            Matrix<Type> power(unsigned n);
+            Matrix<Type> power(unsigned n) const;  // exponentiation by squaring
 
 };
 
-#include "matrix.cpp"
-
 #endif /* matrix_hpp */